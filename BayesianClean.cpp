@@ -2,8 +2,43 @@
 #include "Compensative.h"
 #include "CompensativeParameter.h"
 #include "dataset.h"
+#include "MemoryFootprint.h"
 #include <iostream>
 #include <memory>
+#include <type_traits>
+
+template <typename T> struct is_unordered_map : std::false_type {};
+template <typename K, typename V> struct is_unordered_map<std::unordered_map<K, V>> : std::true_type {};
+
+// Entries in the innermost maps and buckets over all levels of a nested
+// unordered_map
+template <typename K, typename V>
+static void add_map_size(const std::unordered_map<K, V>& m, size_t& entries, size_t& buckets)
+{
+    buckets += m.bucket_count();
+    if constexpr (is_unordered_map<V>::value) {
+        for (const auto& kv : m)
+            add_map_size(kv.second, entries, buckets);
+    } else {
+        entries += m.size();
+    }
+}
+
+template <typename Map>
+static void report_map_size(StageReport& report, const std::string& name, const Map& m)
+{
+    size_t entries = 0, buckets = 0;
+    add_map_size(m, entries, buckets);
+    report.set_size(name + "_entries", entries);
+    report.set_size(name + "_buckets", buckets);
+}
+
+// Approximate heap bytes of each part of a component, as <prefix>_<part>_bytes
+static void report_footprint(StageReport& report, const std::string& prefix, const std::map<std::string, size_t>& parts)
+{
+    for (const auto& kv : parts)
+        report.set_size(prefix + "_" + kv.first + "_bytes", kv.second);
+}
 
 BayesianClean::BayesianClean(DataFrame dirty_df, DataFrame clean_df,
                              string infer_strategy,
@@ -15,70 +50,89 @@ BayesianClean::BayesianClean(DataFrame dirty_df, DataFrame clean_df,
                              string model_save_path,
                              map<string, AttrInfo> attr_type,
                              vector<Edge> fix_edge,
-                             string model_choice)
+                             string model_choice,
+                             double repair_budget,
+                             StructureOptions structure_options,
+                             std::shared_ptr<StageReport> shared_report)
     : dirty_data(dirty_df), clean_data(clean_df), infer_strategy(infer_strategy),
       tuple_prun(tuple_prun), maxiter(maxiter), num_worker(num_worker),
-      chunksize(chunksize), model_path(model_path), model_save_path(model_save_path),
-      attr_type(attr_type), fix_edge(fix_edge), model_choice(model_choice)
+      chunksize(chunksize), repair_budget(repair_budget), model_path(model_path), model_save_path(model_save_path),
+      attr_type(attr_type), fix_edge(fix_edge), model_choice(model_choice),
+      structure_options(structure_options),
+      report(shared_report ? shared_report : std::make_shared<StageReport>())
 {
+    start_time = std::chrono::high_resolution_clock::now();
+    report->begin("preprocess", dirty_data.rows.size());
     std::cout << "+++++++++data loading++++++++" << std::endl;
     // Create a Dataset loader and preprocess the data
     std::shared_ptr<Dataset> dataLoader = std::make_shared<Dataset>();
     DataFrame processedData = dataLoader->pre_process_data(dirty_data, attr_type);
+    report->end();
+    report_footprint(*report, "dataframe", {{"dirty", footprint(dirty_data.rows)},
+                                            {"clean", footprint(clean_data.rows)},
+                                            {"processed", footprint(processedData.rows)}});
     std::cout << "+++++++++data loading complete++++++++" << std::endl;
 
     std::cout << "+++++++++correlation computing++++++++" << std::endl;
     // Create Compensative with the processed DataFrame and attribute types
     dataLoader->print_dataframe(processedData);
 
+    report->begin("compensative", processedData.rows.size());
     compensative = std::make_shared<Compensative>(processedData, attr_type);
     compensative->build();
-    occurrenceList = compensative->getOccurrenceList();
-    frequencyList = compensative->getFrequencyList();
-
-    occurrence_1 = compensative->getOccurrence1();
-    compensative->printFrequencyList(frequencyList);
-    compensative->printOccurrence1(occurrence_1);
-    compensative->printOccurrenceList(occurrenceList);
-
-    structureLearning = std::make_shared<BNStructure>(processedData, model_path, model_choice, fix_edge, model_save_path);
+    report_map_size(*report, "frequency", compensative->getFrequencyList());
+    report_map_size(*report, "occurrence", compensative->getOccurrenceList());
+    report_map_size(*report, "occurrence1", compensative->getOccurrence1());
+    report->end();
+    report_footprint(*report, "compensative", compensative->memory_footprint());
+    report->set_size("intern_pool_values", InternPool::global().size());
+    report_footprint(*report, "intern", {{"pool", InternPool::global().memory_footprint()}});
+    compensative->printFrequencyList(compensative->getFrequencyList());
+    compensative->printOccurrence1(compensative->getOccurrence1());
+    compensative->printOccurrenceList(compensative->getOccurrenceList());
+
+    report->begin("structure", processedData.rows.size());
+    structureLearning = std::make_shared<BNStructure>(processedData, model_path, model_choice, fix_edge, model_save_path, num_worker, structure_options);
     BNResult bn_result = structureLearning->get_bn();
+    report->end();
     structureLearning->print_bn_result(bn_result);
 
-    compensativeParameter = std::make_shared<CompensativeParameter>(attr_type,
-                                                                    frequencyList,
-                                                                    occurrenceList,
-                                                                    bn_result.full_graph,
-                                                                    processedData);
+    // Published once; every later stage reads this copy
+    model = ModelSnapshot::publish(*compensative, std::move(bn_result));
+    report_footprint(*report, "model", model->memory_footprint());
+
+    // Dirty and processed rows share one schema, so candidate codes taken
+    // from the processed data can be written straight into repaired rows
+    auto schema = std::make_shared<EncodedSchema>(processedData.columns);
+    EncodedTable processedTable = EncodedTable::encode(processedData, schema);
+    EncodedTable dirtyTable = EncodedTable::encode(dirty_data, schema, "A Null Cell");
+
+    compensativeParameter = std::make_shared<CompensativeParameter>(attr_type, model, processedTable);
 
     std::cout << "\n=========== Running CompensativeParameter Tests ===========\n";
 
     if (processedData.rows.empty())
     {
+        end_time = std::chrono::high_resolution_clock::now();
         std::cerr << "[Test] No data rows in processedData. Skipping test.\n";
         return;
     }
 
     int row_index = 0;
 
-    Row row_map;
+    RowSpan row_span = processedTable.row(row_index);
     const vector<string> &col_names = processedData.columns;
-    const vector<string> &row_values = processedData.rows[row_index];
-    for (size_t i = 0; i < col_names.size(); ++i)
-    {
-        if (i < row_values.size())
-        {
-            row_map[col_names[i]] = row_values[i];
-        }
-    }
 
     // === Test 1: return_penalty ===
     std::string test_attr = ""; // choose first valid attr with a non-empty value
+    std::string obs;
     for (const auto &[attr_name, info] : attr_type)
     {
-        if (row_map.find(attr_name) != row_map.end() && !row_map[attr_name].empty())
+        int id = schema->attr_id(attr_name);
+        if (id >= 0 && !processedTable.value(row_index, id).empty())
         {
             test_attr = attr_name;
+            obs = processedTable.value(row_index, id);
             break;
         }
     }
@@ -86,16 +140,19 @@ BayesianClean::BayesianClean(DataFrame dirty_df, DataFrame clean_df,
     {
         std::cerr << "[Test] No suitable attribute found for testing return_penalty.\n";
     }
-    std::string obs = row_map[test_attr];
     std::vector<std::string> prior_candidates;
-    for (const auto &[val, _] : frequencyList[test_attr])
+    auto freq_it = model->frequency.find(test_attr);
+    if (freq_it != model->frequency.end())
     {
-        prior_candidates.push_back(val);
-        if (prior_candidates.size() >= 5)
-            break;
+        for (const auto &[val, _] : freq_it->second)
+        {
+            prior_candidates.push_back(val);
+            if (prior_candidates.size() >= 5)
+                break;
+        }
     }
     std::cout << "[Test] Testing return_penalty for attribute: " << test_attr << ", observed: " << obs << "\n";
-    auto penalty_scores = compensativeParameter->return_penalty(obs, test_attr, row_index, row_map, prior_candidates);
+    auto penalty_scores = compensativeParameter->return_penalty(obs, test_attr, row_index, row_span, prior_candidates);
 
     std::cout << "→ return_penalty output:\n";
     for (const auto &[cand, score] : penalty_scores)
@@ -105,12 +162,17 @@ BayesianClean::BayesianClean(DataFrame dirty_df, DataFrame clean_df,
 
     // === Test 2: init_tf_idf ===
     std::cout << "\n[Test] Initializing TF-IDF structure...\n";
+    report->begin("tfidf", processedData.rows.size());
     compensativeParameter->init_tf_idf(col_names);
+    report->end();
+    report_footprint(*report, "compensative_parameter", compensativeParameter->memory_footprint());
+    report_footprint(*report, "encoded", {{"schema", schema->memory_footprint()},
+                                          {"tables", processedTable.memory_footprint() + dirtyTable.memory_footprint()}});
 
     // === Test 3: return_penalty_test ===
     std::cout << "[Test] Testing return_penalty_test for attribute: " << test_attr << "\n";
     auto penalty_scores_tfidf = compensativeParameter->return_penalty_test(
-        obs, test_attr, row_index, row_map, prior_candidates, col_names);
+        obs, test_attr, row_index, row_span, prior_candidates, col_names);
 
     std::cout << "→ return_penalty_test output (TF-IDF):\n";
     for (const auto &[cand, score] : penalty_scores_tfidf)
@@ -120,36 +182,12 @@ BayesianClean::BayesianClean(DataFrame dirty_df, DataFrame clean_df,
 
     std::cout << "\n=========== CompensativeParameter Tests Complete ===========\n";
 
-    // --- convert DataFrame → DataMap
-    using Row = std::unordered_map<std::string, std::string>;
-    using DataMap = std::vector<Row>;
-
-    DataMap dirtyMap, processedMap;
-    // build dirtyMap
-    for (auto &vals : dirty_data.rows)
-    {
-        Row r;
-        for (size_t j = 0; j < dirty_data.columns.size(); ++j)
-            r[dirty_data.columns[j]] = vals[j];
-        dirtyMap.push_back(std::move(r));
-    }
-    // build processedMap
-    for (auto &vals : processedData.rows)
-    {
-        Row r;
-        for (size_t j = 0; j < processedData.columns.size(); ++j)
-            r[processedData.columns[j]] = vals[j];
-        processedMap.push_back(std::move(r));
-    }
-
+    report->begin("repair", dirty_data.rows.size());
     inference = std::make_shared<Inference>(
-        /*dirtyData*/ dirtyMap,
-        /*processedData*/ processedMap,
-        /*model*/ bn_result.full_graph,
-        /*modelDict*/ bn_result.partition_graphs,
+        /*dirtyData*/ dirtyTable,
+        /*processedData*/ processedTable,
+        /*model*/ model,
         /*attrType*/ attr_type,
-        /*frequencyList*/ frequencyList,
-        /*occurrence1*/ occurrence_1,
         /*compParam*/ compensativeParameter,
         /*strategy*/ infer_strategy,
         /*chunkSize*/ chunksize,
@@ -157,6 +195,17 @@ BayesianClean::BayesianClean(DataFrame dirty_df, DataFrame clean_df,
         /*tuplePrun*/ tuple_prun,
         true);
 
-    repair_list = inference->repair(processedMap, clean_data, bn_result.full_graph, attr_type);
+    if (repair_budget > 0)
+    {
+        AnytimeResult anytime = inference->repair_anytime(repair_budget);
+        repair_list = std::move(anytime.data);
+        repair_status = std::move(anytime.status);
+    }
+    else
+    {
+        repair_list = inference->repair(processedTable, clean_data, model->full_graph, attr_type);
+    }
+    report->end();
+    report_footprint(*report, "inference", inference->memory_footprint());
     end_time = std::chrono::high_resolution_clock::now();
 }
\ No newline at end of file
@@ -13,6 +13,9 @@
 #include "Inference.h"
 #include "CompensativeParameter.h"
 #include "BayesianNetwork.h"
+#include "EncodedTable.h"
+#include "ModelSnapshot.h"
+#include "StageReport.h"
 
 class BayesianClean
 {
@@ -28,14 +31,23 @@ public:
                   std::string model_save_path = "",
                   std::map<std::string, AttrInfo> attr_type = {},
                   std::vector<Edge> fix_edges = {},
-                  std::string model_choice = "");
+                  std::string model_choice = "",
+                  double repair_budget = 0.0,
+                  StructureOptions structure_options = StructureOptions(),
+                  std::shared_ptr<StageReport> shared_report = nullptr);
+
+    // Per-stage costs of the run; stages recorded by the caller in the
+    // report passed in (e.g. loading) come first
+    const StageReport& stage_report() const { return *report; }
 
 private:
     std::chrono::time_point<std::chrono::high_resolution_clock> start_time, end_time;
     DataFrame dirty_data;
     DataFrame clean_data;
 
-    DataMap repair_list;
+    EncodedTable repair_list;
+    // Per-cell outcome when repair ran under a time budget
+    std::vector<CellStatus> repair_status;
     
     std::map<std::string, AttrInfo> attr_type;
     std::vector<Edge> fix_edge;
@@ -47,6 +59,9 @@ private:
     int maxiter;
     int num_worker;
     int chunksize;
+    double repair_budget;  // seconds; 0 repairs without a deadline
+    StructureOptions structure_options;
+    std::shared_ptr<StageReport> report;
 
     std::shared_ptr<Dataset> dataLoader;
     std::shared_ptr<Compensative> compensative;
@@ -54,22 +69,8 @@ private:
     std::shared_ptr<BNStructure> structureLearning;
     std::shared_ptr<Inference> inference;
 
-    std::unordered_map<std::string,
-                       std::unordered_map<std::string,
-                                          std::unordered_map<std::string,
-                                                             std::unordered_map<std::string, double>>>>
-        occurrenceList;
-
-    std::unordered_map<std::string,
-                       std::unordered_map<std::string, int>>
-        frequencyList;
-
-    unordered_map<string,
-                  unordered_map<string,
-                                unordered_map<string,
-                                              unordered_map<string, int>>>>
-        occurrence_1;
-
+    // Statistics and graphs, shared with compensativeParameter and inference
+    ModelSnapshotPtr model;
 };
 
 #endif // BAYESIAN_CLEAN_H
@@ -1,5 +1,23 @@
 #include "dataset.h"
 
+AttrInfo::AttrInfo(const string& pat, const string& typ, bool nullOK, double minV, double maxV)
+    : type(typ), allowNull(nullOK), numerical(typ == "Numerical"), min_v(minV), max_v(maxV)
+{
+    set_pattern(pat);
+}
+
+void AttrInfo::set_pattern(const string& pat) {
+    pattern = pat;
+    compiled.reset();
+    if (pat.empty())
+        return;
+    try {
+        compiled = make_shared<const regex>(pat);
+    } catch (const regex_error&) {
+        cerr << "Invalid pattern: " << pat << endl;
+    }
+}
+
 Dataset::Dataset() : tags("A Null Cell") { }
 
 DataFrame Dataset::get_data(const string& path) {
@@ -21,21 +39,25 @@ DataFrame Dataset::get_data(const string& path) {
     }
     // Read remaining lines as rows
     while (getline(file, line)) {
-        vector<string> row;
-        stringstream ss(line);
-        string cell;
-        while (getline(ss, cell, ',')) {
-            row.push_back(cell);
-        }
-        while (row.size() < df.columns.size()) {
-            row.push_back("");
-        }
-        df.rows.push_back(row);
+        df.rows.push_back(split_line(line, df.columns.size()));
     }
     file.close();
     return df;
 }
 
+vector<string> Dataset::split_line(const string& line, size_t num_columns) {
+    vector<string> row;
+    stringstream ss(line);
+    string cell;
+    while (getline(ss, cell, ',')) {
+        row.push_back(cell);
+    }
+    while (row.size() < num_columns) {
+        row.push_back("");
+    }
+    return row;
+}
+
 // Filter columns and replace missing values
 DataFrame Dataset::get_real_data(const DataFrame& data, const map<string, AttrInfo>& attr_type) {
     DataFrame df;
@@ -85,100 +107,92 @@ void Dataset::print_dataframe(const DataFrame& df) const {
     }
 }
 
-void Dataset::dfs_line(vector<vector<string>>& re_lines,
-                       vector<string>& current_line,
-                       int attr_index,
-                       const vector<string>& keys,
-                       const vector<vector<string>>& values) {
-    if (attr_index == keys.size()) {
-        re_lines.push_back(current_line);
-        return;
-    }
-    for (const auto& val : values[attr_index]) {
-        int index = attr_index; 
-        string old_value = current_line[index];
-        current_line[index] = val;
-        dfs_line(re_lines, current_line, attr_index + 1, keys, values);
-        current_line[index] = old_value;
-    }
-}
+vector<string> CandidateCursor::cell_candidates(const string& cell, const AttrInfo& info) {
+    if (!info.compiled)
+        return {cell};
 
-vector<vector<string>> Dataset::change_add_line(const vector<string>& data_line,
-                                                  int line_index,
-                                                  const vector<vector<string>>& add_lines,
-                                                  const vector<string>& attr_line,
-                                                  const vector<string>& attrs) {
-    vector<string> current_line = data_line;
-    vector<vector<string>> result_lines;
-    dfs_line(result_lines, current_line, 0, attr_line, add_lines);
-    return result_lines;
-}
+    smatch match;
+    if (!regex_search(cell, match, *info.compiled))
+        return {cell};
 
-DataFrame Dataset::pre_process_data(const DataFrame& data, const map<string, AttrInfo>& attr_type) {
-    vector<string> attrs;
-    for (const auto& kv : attr_type) {
-        attrs.push_back(kv.first);
+    string val = match.str(0);
+    if (info.numerical) {
+        try {
+            double num = stod(val);
+            if (floor(num) == num) {
+                val = to_string(static_cast<int>(num));  // Convert to integer if whole number
+            } else {
+                val = to_string(num);
+            }
+        } catch (const std::invalid_argument& e) {
+
+        } catch (const std::out_of_range& e) {
+
+        }
     }
-    
-    DataFrame df_train;
-    df_train.columns = attrs;
+    return {val};
+}
+
+CandidateCursor::CandidateCursor(const DataFrame& data, const map<string, AttrInfo>& attr_type,
+                                 const string& missing)
+    : data(data), attr_type(attr_type), missing(missing) {
     map<string, int> colIndex;
     for (int j = 0; j < data.columns.size(); j++) {
         colIndex[data.columns[j]] = j;
     }
-    
-    for (int i = 0; i < data.rows.size(); i++) {
-        const auto& row = data.rows[i];
-        vector<vector<string>> candidate_values_per_attr;
-        vector<string> attr_names;
-        
-        for (const auto& at : attrs) {
-            attr_names.push_back(at);
-            vector<string> candidates;
-            string cell_value = tags;  // Initialize with default value for missing data
-            
-            if (colIndex.find(at) != colIndex.end()) {
-                cell_value = row[colIndex[at]];
-            }
-            
-            if (!attr_type.at(at).pattern.empty()) {
-                regex pattern(attr_type.at(at).pattern);
-                smatch match;
-                
-                if (regex_search(cell_value, match, pattern)) {
-                    string val = match.str(0);
-                    if (attr_type.at(at).type == "Numerical") {
-                        try {
-                            double num = stod(val);
-                            if (floor(num) == num) {
-                                val = to_string(static_cast<int>(num));  // Convert to integer if whole number
-                            } else {
-                                val = to_string(num);
-                            }
-                        } catch (const std::invalid_argument& e) {
-            
-                        } catch (const std::out_of_range& e) {
-                     
-                        }
-                    }
-                    candidates.push_back(val);
-                } else {
-                    candidates.push_back(cell_value);
-                }
-            } else {
-                candidates.push_back(cell_value);
+    for (const auto& kv : attr_type) {
+        attrs.push_back(kv.first);
+        auto it = colIndex.find(kv.first);
+        source.push_back(it == colIndex.end() ? -1 : it->second);
+    }
+    candidates.resize(attrs.size());
+    choice.resize(attrs.size());
+}
+
+bool CandidateCursor::load(size_t i) {
+    const auto& row = data.rows[i];
+    current = row;
+    if (current.size() < attrs.size())
+        current.resize(attrs.size());
+    for (size_t a = 0; a < attrs.size(); ++a) {
+        const string& cell = source[a] >= 0 ? row[source[a]] : missing;
+        candidates[a] = cell_candidates(cell, attr_type.at(attrs[a]));
+        if (candidates[a].empty())
+            return false;
+        choice[a] = 0;
+        current[a] = candidates[a][0];
+    }
+    return true;
+}
+
+bool CandidateCursor::next() {
+    if (started && line < data.rows.size()) {
+        // Odometer step over the candidate product of the current input row
+        for (size_t a = attrs.size(); a-- > 0;) {
+            if (++choice[a] < candidates[a].size()) {
+                current[a] = candidates[a][choice[a]];
+                return true;
             }
-            candidate_values_per_attr.push_back(candidates);
+            choice[a] = 0;
+            current[a] = candidates[a][0];
         }
+        ++line;
+    }
+    started = true;
+    for (; line < data.rows.size(); ++line)
+        if (load(line))
+            return true;
+    return false;
+}
 
-        vector<vector<string>> new_rows = change_add_line(row, i, candidate_values_per_attr, attr_names, attrs);
-        
-        df_train.rows.reserve(df_train.rows.size() + new_rows.size());
-        for (auto& new_row : new_rows) {
-            df_train.rows.push_back(new_row);
-        }
+DataFrame Dataset::pre_process_data(const DataFrame& data, const map<string, AttrInfo>& attr_type) {
+    CandidateCursor cursor = candidate_rows(data, attr_type);
+    DataFrame df_train;
+    df_train.columns = cursor.columns();
+    df_train.rows.reserve(data.rows.size());
+    while (cursor.next()) {
+        df_train.rows.push_back(cursor.row());
     }
-    
     return df_train;
 }
 
@@ -218,4 +232,58 @@ void Dataset::get_actual_error(const DataFrame& df1, const DataFrame& df2) {
 map<pair<int, string>, string> Dataset::get_error(const DataFrame& df1, const DataFrame& df2) {
     get_actual_error(df1, df2);
     return actual_error;
-}
\ No newline at end of file
+}
+RowSampler::RowSampler(size_t sample_size, size_t recheck_size, int stratify_column, unsigned seed)
+    : sample_size(sample_size), capacity(max(sample_size, recheck_size)),
+      stratify_column(stratify_column), rng(seed), uniform(0.0, 1.0) {}
+
+void RowSampler::add(const vector<string>& row) {
+    const string& value = (stratify_column >= 0 && stratify_column < (int)row.size())
+                              ? row[stratify_column] : string();
+    Stratum& st = strata[value];
+    st.rows++;
+    double key = uniform(rng);
+    size_t seq = seen++;
+    if (capacity == 0)
+        return;
+    if (st.heap.size() < capacity) {
+        st.heap.push_back({key, seq, row});
+        push_heap(st.heap.begin(), st.heap.end());
+    } else if (key < st.heap.front().key) {
+        pop_heap(st.heap.begin(), st.heap.end());
+        st.heap.back() = {key, seq, row};
+        push_heap(st.heap.begin(), st.heap.end());
+    }
+}
+
+DataFrame RowSampler::sample(const vector<string>& columns) const {
+    return take(columns, sample_size);
+}
+
+DataFrame RowSampler::recheck(const vector<string>& columns) const {
+    return take(columns, capacity);
+}
+
+DataFrame RowSampler::take(const vector<string>& columns, size_t size) const {
+    vector<const Kept*> chosen;
+    for (const auto& kv : strata) {
+        const Stratum& st = kv.second;
+        size_t quota = size;
+        if (strata.size() > 1)
+            quota = max<size_t>(1, size_t(double(size) * st.rows / max<size_t>(seen, 1)));
+        vector<const Kept*> kept;
+        for (const auto& k : st.heap)
+            kept.push_back(&k);
+        sort(kept.begin(), kept.end(), [](const Kept* a, const Kept* b) { return a->key < b->key; });
+        if (kept.size() > quota)
+            kept.resize(quota);
+        chosen.insert(chosen.end(), kept.begin(), kept.end());
+    }
+    sort(chosen.begin(), chosen.end(), [](const Kept* a, const Kept* b) { return a->seq < b->seq; });
+
+    DataFrame df;
+    df.columns = columns;
+    for (const Kept* k : chosen)
+        df.rows.push_back(k->row);
+    return df;
+}
@@ -8,11 +8,13 @@
 #include <string>
 #include <regex>
 #include <map>
+#include <memory>
 #include <unordered_map>
 #include <thread>
 #include <mutex>
 #include <cmath>
 #include <algorithm>
+#include <random>
 
 using namespace std;
 
@@ -22,14 +24,106 @@ struct DataFrame {
     
 };
 
-// Structure to hold attribute information.
+// Structure to hold attribute information. Everything is parsed when the
+// constraints are loaded, so checks on cells compare no strings.
 struct AttrInfo {
     string pattern;
     string type;
-    string allowNull;
+    bool allowNull = false;
+    bool repairable = true;
+    bool numerical = false;           // type == "Numerical"
+    double min_v = -HUGE_VAL;         // value range if numerical, else length range
+    double max_v = HUGE_VAL;
+    shared_ptr<const regex> compiled; // pattern; null if empty or invalid
+
+    AttrInfo(const string& pat = "", const string& typ = "", bool nullOK = false,
+             double minV = -HUGE_VAL, double maxV = HUGE_VAL);
+
+    // Replaces the pattern and compiles it
+    void set_pattern(const string& pat);
+};
+
+// Single-pass row sample of a stream of unknown length. Every row draws a
+// random key and the rows with the smallest keys are kept, so sample() is
+// a uniform sample nested inside the larger recheck() sample. With a
+// stratify column, keys are kept per value of that column and each stratum
+// gets a share of the sample proportional to its row count (at least one).
+class RowSampler {
+public:
+    RowSampler(size_t sample_size, size_t recheck_size = 0,
+               int stratify_column = -1, unsigned seed = 0);
+
+    void add(const vector<string>& row);
+
+    size_t rows_seen() const { return seen; }
+
+    // Kept rows, in stream order
+    DataFrame sample(const vector<string>& columns) const;
+    DataFrame recheck(const vector<string>& columns) const;
+
+private:
+    struct Kept {
+        double key;
+        size_t seq;
+        vector<string> row;
+        bool operator<(const Kept& o) const { return key < o.key; }
+    };
+    struct Stratum {
+        size_t rows = 0;
+        vector<Kept> heap;   // max-heap on key, at most capacity entries
+    };
+
+    DataFrame take(const vector<string>& columns, size_t size) const;
+
+    size_t sample_size;
+    size_t capacity;         // max(sample_size, recheck_size)
+    int stratify_column;
+    mt19937_64 rng;
+    uniform_real_distribution<double> uniform;
+    map<string, Stratum> strata;
+    size_t seen = 0;
+};
+
+// Candidate rows of a DataFrame, enumerated one at a time: for every input
+// row, each combination of one candidate per attribute (attr_type order,
+// the last attribute varying fastest). Only the current row is held, so
+// memory stays linear however many candidates a cell has. data and
+// attr_type must outlive the cursor.
+class CandidateCursor {
+public:
+    CandidateCursor(const DataFrame& data, const map<string, AttrInfo>& attr_type,
+                    const string& missing);
+
+    // Moves to the next candidate row; false once every input row is done
+    bool next();
+
+    // The attr_type attributes, in the order of the first cells of row()
+    const vector<string>& columns() const { return attrs; }
+
+    // One cell per attribute, followed by any cells of the input row
+    // beyond the attribute count. Valid until the next call to next().
+    const vector<string>& row() const { return current; }
+
+    // Index in data of the row the current candidate row came from
+    size_t source_row() const { return line; }
 
-    AttrInfo(const string& pat = "", const string& typ = "", const string& nullOK = "N")
-        : pattern(pat), type(typ), allowNull(nullOK) {}
+    // Candidate values of a cell: the pattern match, normalized if numerical
+    static vector<string> cell_candidates(const string& cell, const AttrInfo& info);
+
+private:
+    // Computes the candidates of data.rows[i] and sets the first combination
+    bool load(size_t i);
+
+    const DataFrame& data;
+    const map<string, AttrInfo>& attr_type;
+    string missing;
+    vector<string> attrs;
+    vector<int> source;                  // column of data per attribute, -1 if absent
+    vector<vector<string>> candidates;   // per attribute, for the current input row
+    vector<size_t> choice;               // candidate index per attribute
+    vector<string> current;
+    size_t line = 0;
+    bool started = false;
 };
 
 class Dataset {
@@ -43,6 +137,9 @@ public:
     // Reads a CSV file and returns a DataFrame
     DataFrame get_data(const string& path);
 
+    // Splits one CSV line on ',' and pads it with empty cells up to num_columns
+    static vector<string> split_line(const string& line, size_t num_columns = 0);
+
     // Filters the DataFrame to include only columns specified in attr_type
     DataFrame get_real_data(const DataFrame& data, const map<string, AttrInfo>& attr_type);
 
@@ -52,26 +149,17 @@ public:
     // Preprocesses the data by applying regex patterns and generating candidate rows
     DataFrame pre_process_data(const DataFrame& data, const map<string, AttrInfo>& attr_type);
 
+    // The rows pre_process_data would return, without storing them
+    CandidateCursor candidate_rows(const DataFrame& data, const map<string, AttrInfo>& attr_type) const {
+        return CandidateCursor(data, attr_type, tags);
+    }
+
     // Compares two DataFrames cell by cell and records differences
     void get_actual_error(const DataFrame& df1, const DataFrame& df2);
 
     // Wrapper that calls get_actual_error and returns the error map
     map<pair<int, string>, string> get_error(const DataFrame& df1, const DataFrame& df2);
 
-private:
-    // DFS that generates candidate row combinations
-    void dfs_line(vector<vector<string>>& re_lines,
-                  vector<string>& current_line,
-                  int attr_index,
-                  const vector<string>& keys,
-                  const vector<vector<string>>& values);
-
-    // Generates candidate rows for a given row
-    vector<vector<string>> change_add_line(const vector<string>& data_line,
-                                             int line_index,
-                                             const vector<vector<string>>& add_lines,
-                                             const vector<string>& attr_line,
-                                             const vector<string>& attrs);
 };
 
 #endif // DATASET_H
\ No newline at end of file
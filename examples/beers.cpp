@@ -12,6 +12,10 @@
 #include "../dataset.h"
 #include "../include/UserConstraints.h"
 #include "../BayesianClean.h"
+#include "../include/Pipeline.h"
+#include "../include/AllocTracker.h"
+#include "../include/StageReport.h"
+#include "../include/Trace.h"
 using namespace std;
 
 
@@ -82,9 +86,29 @@ std::tuple<double, double, double> analysis(
 int main(int argc, char* argv[])
 {
     std::string versionName = "";
-
-    if (argc == 2) {
-        versionName = argv[1];
+    // Paths to the dirty and clean data and the UC file, replaceable by
+    // positional arguments, e.g. with the output of gen_dirty
+    vector<string> paths = {"data/dirty.csv", "data/clean.csv", "json/beers.json"};
+    size_t given = 0;
+    // Per-stage timing, memory and throughput, written as JSON at the end
+    std::string report_path = "stage_report.json";
+    // --counters adds hardware counters (IPC, misses per row) to the report
+    bool count_hardware = false;
+    // --alloc adds allocation counts, bytes and peak live bytes per stage
+
+    for (int k = 1; k < argc; ++k) {
+        std::string arg = argv[k];
+        if (arg.rfind("--report=", 0) == 0) {
+            report_path = arg.substr(9);
+        } else if (arg == "--counters") {
+            count_hardware = true;
+        } else if (arg == "--alloc") {
+            alloc::set_tracking(true);
+        } else if (arg[0] == '-') {
+            versionName = arg;
+        } else if (given < paths.size()) {
+            paths[given++] = arg;
+        }
     }
 
     if (versionName.empty()) {
@@ -95,20 +119,27 @@ int main(int argc, char* argv[])
         std::cout << "Running BCleanₚᵢ: variant with Partition Inference optimization." << std::endl;
     } else if (versionName == "-PIP") {
         std::cout << "Running BCleanₚᵢₚ: variant with Partition Inference and Pruning optimizations." << std::endl;
+    } else if (versionName == "-PIPE") {
+        std::cout << "Running BClean with the pipelined stage executor." << std::endl;
     } else {
         std::cout << "Unknown version argument: " << versionName << std::endl;
         return 1; // exit with error
     }
 
     Dataset dataset;
-    // Paths to the dirty and clean data
-    string dirty_path = "data/dirty.csv";
-    string clean_path = "data/clean.csv";
-    string json_path = "json/beers.json";
-
+    string dirty_path = paths[0];
+    string clean_path = paths[1];
+    string json_path = paths[2];
+
+    auto report = std::make_shared<StageReport>();
+    if (count_hardware)
+        report->enable_counters();
+    report->begin("load", 0);
     // Load data using the Dataset methods.
     DataFrame dirty_data = dataset.get_data(dirty_path);
     DataFrame clean_data = dataset.get_data(clean_path);
+    report->set_rows(dirty_data.rows.size() + clean_data.rows.size());
+    report->end();
 
     map<string, AttrInfo> attr_type;
     if (!(versionName == "-UC")) {
@@ -142,18 +173,8 @@ int main(int argc, char* argv[])
         cout << endl;
 
 
-        // Simulating repair data
-        for (const auto &[col, constraints] : updated_uc_data)
-        {
-            if (constraints.find("type") != constraints.end())
-            {
-                attr_type[col] = {constraints.at("type")}; // Extract type from UC
-            }
-            else
-            {
-                attr_type[col] = {"Unknown"}; // Ensure all attributes are included
-            }
-        }
+        // Typed constraints: type, pattern, AllowNull and min/max
+        attr_type = uc.get_attr_info();
 
         // **Call get_real_data() correctly**
         dirty_data = dataset.get_real_data(dirty_data, attr_type);
@@ -163,6 +184,19 @@ int main(int argc, char* argv[])
     // Starting timing
     auto start_time = chrono::system_clock::now();
 
+    if (versionName == "-PIPE") {
+        std::cout << "\n===== Running pipelined executor =====\n";
+        PipelineOptions options;
+        options.infer_strategy = "Compensative";
+        options.tuple_prun = 0.5;
+        options.chunksize = 50;
+        options.model_choice = "appr";
+
+        PipelineExecutor pipeline(attr_type, options);
+        size_t rows = pipeline.run(dirty_path, "repaired.csv");
+        cout << rows << " repaired rows written to repaired.csv" << endl;
+        pipeline.print_stage_times();
+    } else {
     std::cout << "\n===== Instantiating BayesianClean for Compensative test =====\n";
 
     BayesianClean model(
@@ -177,8 +211,12 @@ int main(int argc, char* argv[])
         "",             // model_save_path
         attr_type,
         {},    // fix_edge
-        "appr" // model_choice
+        "appr", // model_choice
+        0.0,    // repair_budget
+        StructureOptions(),
+        report
     );
+    }
 
     std::cout << "\n===== Evaluating Repair Results =====\n";
 
@@ -219,6 +257,12 @@ int main(int argc, char* argv[])
     auto end_time = chrono::system_clock::now();
     chrono::duration<double> elapsed_time = end_time - start_time;
     cout << "++++++++++++++++++++time using: " << elapsed_time.count() << "+++++++++++++++++++++++" << endl;
+    if (report->write_json(report_path))
+        cout << "Stage report written to " << report_path << endl;
+#ifdef BCLEAN_TRACE
+    if (trace::write_json("trace.json"))
+        cout << "Trace written to trace.json (" << trace::dropped() << " spans dropped)" << endl;
+#endif
 
     // Current date and time
     time_t current_time = chrono::system_clock::to_time_t(end_time);
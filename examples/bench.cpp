@@ -0,0 +1,398 @@
+// Microbenchmarks of the hot kernels on synthetic data, written as JSON so
+// that two builds can be diffed:
+//
+//   ./bench                        # everything, JSON on stdout
+//   ./bench --filter penalty       # only benchmarks whose name matches
+//   ./bench --min-time 1 --out bench.json
+//   ./bench --counters             # adds IPC and misses per op
+//
+// Every benchmark reports ns/op, ops/s and heap allocations and bytes per
+// op (counted by AllocTracker.h), where an op is the unit named by "op" in
+// its entry. Data comes from fixed seeds, so runs are comparable.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "../dataset.h"
+#include "../include/BNStructure.h"
+#include "../include/Compensative.h"
+#include "../include/CompensativeParameter.h"
+#include "../include/AllocTracker.h"
+#include "../include/Inference.h"
+#include "../include/ModelSnapshot.h"
+#include "../include/PerfCounters.h"
+using namespace std;
+
+//--------------------------------- harness ------------------------------------
+
+struct BenchResult {
+    string name;
+    vector<pair<string, long>> params;
+    string op;
+    size_t iterations = 0;
+    double ns_per_op = 0, ops_per_sec = 0, allocs_per_op = 0, bytes_per_op = 0;
+    PerfCounters::Values counters;   // over all timed calls
+    double ops = 0;
+};
+
+struct Options {
+    string filter;
+    double min_time = 0.2;   // seconds per benchmark
+    string out;
+    bool counters = false;
+};
+
+static Options g_options;
+static vector<BenchResult> g_results;
+static unique_ptr<PerfCounters> g_counters;
+
+// Runs body (ops_per_call ops each call) after one warm-up call until
+// min_time has passed and at least three calls were made. Library output
+// is discarded meanwhile.
+static void run_bench(const string& name, vector<pair<string, long>> params, const string& op,
+                      size_t ops_per_call, const function<void()>& body)
+{
+    if (!g_options.filter.empty() && name.find(g_options.filter) == string::npos)
+        return;
+
+    ofstream null_out("/dev/null");
+    streambuf* saved = cout.rdbuf(null_out.rdbuf());
+
+    using Clock = chrono::steady_clock;
+    body();
+    size_t calls = 0;
+    const alloc::Counters before = alloc::snapshot();
+    if (g_counters)
+        g_counters->start();
+    const auto start = Clock::now();
+    double elapsed = 0;
+    do {
+        body();
+        ++calls;
+        elapsed = chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < g_options.min_time || calls < 3);
+    PerfCounters::Values counters = g_counters ? g_counters->stop() : PerfCounters::Values();
+    const alloc::Counters after = alloc::snapshot();
+    const uint64_t allocs = after.allocs - before.allocs, bytes = after.bytes - before.bytes;
+
+    cout.rdbuf(saved);
+
+    BenchResult r;
+    r.name = name;
+    r.params = move(params);
+    r.op = op;
+    r.iterations = calls;
+    const double ops = double(calls) * double(ops_per_call);
+    r.ns_per_op = elapsed * 1e9 / ops;
+    r.ops_per_sec = ops / elapsed;
+    r.allocs_per_op = double(allocs) / ops;
+    r.bytes_per_op = double(bytes) / ops;
+    r.counters = counters;
+    r.ops = ops;
+    g_results.push_back(r);
+
+    cerr << name;
+    for (const auto& p : r.params)
+        cerr << " " << p.first << "=" << p.second;
+    cerr << ": " << r.ns_per_op << " ns/" << op << ", " << r.allocs_per_op << " allocs/" << op << endl;
+}
+
+static string json_escape(const string& s)
+{
+    string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+static void write_json(ostream& out)
+{
+    out << "{\n  \"compiler\": \"" << json_escape(__VERSION__) << "\",\n  \"benchmarks\": [\n";
+    for (size_t k = 0; k < g_results.size(); ++k) {
+        const BenchResult& r = g_results[k];
+        out << "    {\"name\": \"" << r.name << "\", \"params\": {";
+        for (size_t p = 0; p < r.params.size(); ++p)
+            out << (p ? ", " : "") << "\"" << r.params[p].first << "\": " << r.params[p].second;
+        out << "}, \"op\": \"" << r.op << "\", \"iterations\": " << r.iterations
+            << ", \"ns_per_op\": " << r.ns_per_op
+            << ", \"ops_per_sec\": " << r.ops_per_sec
+            << ", \"allocs_per_op\": " << r.allocs_per_op
+            << ", \"bytes_per_op\": " << r.bytes_per_op;
+        if (r.counters.valid)
+            out << ", \"ipc\": " << r.counters.ipc()
+                << ", \"instructions_per_op\": " << r.counters.instructions / r.ops
+                << ", \"cache_misses_per_op\": " << r.counters.cache_misses / r.ops
+                << ", \"branch_misses_per_op\": " << r.counters.branch_misses / r.ops;
+        out << "}" << (k + 1 < g_results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+//------------------------------ synthetic data --------------------------------
+
+static const size_t kAttrs = 6;
+
+// n rows of attributes a0..a5 with card values each. Every attribute
+// copies the previous one 70% of the time, so there is structure to
+// learn, and 2% of the cells are empty.
+static DataFrame synthetic(size_t n, size_t card, uint32_t seed = 42)
+{
+    mt19937 rng(seed);
+    DataFrame df;
+    for (size_t a = 0; a < kAttrs; ++a)
+        df.columns.push_back("a" + to_string(a));
+    for (size_t r = 0; r < n; ++r) {
+        vector<string> row;
+        size_t prev = rng() % card;
+        for (size_t a = 0; a < kAttrs; ++a) {
+            size_t v = (rng() % 10 < 7) ? prev : rng() % card;
+            prev = v;
+            row.push_back(rng() % 50 == 0 ? "" : "v" + to_string(v));
+        }
+        df.rows.push_back(move(row));
+    }
+    return df;
+}
+
+static map<string, AttrInfo> attr_types(const DataFrame& df)
+{
+    map<string, AttrInfo> types;
+    for (const auto& c : df.columns)
+        types[c] = AttrInfo("", "Categorical");
+    return types;
+}
+
+static vector<string> random_strings(size_t count, size_t length, uint32_t seed)
+{
+    mt19937 rng(seed);
+    const string alphabet = "abcdefghij KLMNOP 0123%";
+    vector<string> out(count);
+    for (auto& s : out)
+        for (size_t k = 0; k < length; ++k)
+            s += alphabet[rng() % alphabet.size()];
+    return out;
+}
+
+// The model a repair run would build, for the scoring kernels
+struct Model {
+    DataFrame processed;
+    map<string, AttrInfo> types;
+    ModelSnapshotPtr snapshot;
+    shared_ptr<EncodedSchema> schema;
+    EncodedTable processedTable;
+    EncodedTable dirtyTable;
+    shared_ptr<CompensativeParameter> param;
+
+    Model(const DataFrame& dirty)
+        : types(attr_types(dirty))
+    {
+        ofstream null_out("/dev/null");
+        streambuf* saved = cout.rdbuf(null_out.rdbuf());
+        Dataset loader;
+        processed = loader.pre_process_data(dirty, types);
+        Compensative compensative(processed, types);
+        compensative.build();
+        BNStructure structure(processed, "", "appr", {});
+        snapshot = ModelSnapshot::publish(compensative, structure.get_bn());
+        schema = make_shared<EncodedSchema>(processed.columns);
+        processedTable = EncodedTable::encode(processed, schema);
+        dirtyTable = EncodedTable::encode(dirty, schema, "A Null Cell");
+        param = make_shared<CompensativeParameter>(types, snapshot, processedTable);
+        param->set_debug(false);
+        cout.rdbuf(saved);
+    }
+
+    // Up to max_count candidates of attr, most frequent first
+    vector<string> prior(const string& attr, size_t max_count) const
+    {
+        vector<pair<int, string>> byCount;
+        for (const auto& kv : snapshot->frequency.at(attr))
+            byCount.emplace_back(-kv.second, kv.first);
+        sort(byCount.begin(), byCount.end());
+        vector<string> out;
+        for (size_t k = 0; k < byCount.size() && k < max_count; ++k)
+            out.push_back(byCount[k].second);
+        return out;
+    }
+};
+
+//-------------------------------- benchmarks ----------------------------------
+
+static void bench_strings()
+{
+    for (size_t length : {8, 32, 128}) {
+        auto a = random_strings(256, length, 1), b = random_strings(256, length, 2);
+        volatile long sink = 0;
+        run_bench("levenshtein_distance", {{"length", long(length)}}, "pair", a.size(), [&]() {
+            for (size_t k = 0; k < a.size(); ++k)
+                sink += CompensativeParameter::levenshtein_distance(a[k], b[k]);
+        });
+        run_bench("canonical", {{"length", long(length)}}, "string", a.size(), [&]() {
+            for (const auto& s : a)
+                sink += long(CompensativeParameter::canonical(s).size());
+        });
+    }
+}
+
+static void bench_compensative()
+{
+    for (size_t n : {200, 1000}) {
+        for (size_t card : {10, 100}) {
+            DataFrame df = synthetic(n, card);
+            auto types = attr_types(df);
+            run_bench("compensative_build", {{"rows", long(n)}, {"cardinality", long(card)}}, "row", n, [&]() {
+                Compensative c(df, types);
+                c.build();
+            });
+        }
+    }
+}
+
+static void bench_structure()
+{
+    for (size_t n : {1000, 10000}) {
+        for (size_t card : {10, 100}) {
+            DataFrame df = synthetic(n, card);
+            BNStructure structure(df, "", "appr", {});
+            run_bench("get_rel", {{"rows", long(n)}, {"cardinality", long(card)}}, "row", n, [&]() {
+                structure.get_rel(df);
+            });
+        }
+    }
+}
+
+static void bench_scoring()
+{
+    for (size_t card : {10, 100}) {
+        const size_t n = 1000;
+        DataFrame dirty = synthetic(n, card);
+        Model model(dirty);
+        const string attr = "a1";
+        const int id = model.schema->attr_id(attr);
+        const vector<string> prior = model.prior(attr, 20);
+        const size_t cells = 64;
+
+        run_bench("return_penalty", {{"rows", long(n)}, {"cardinality", long(card)}}, "cell", cells, [&]() {
+            for (size_t r = 0; r < cells; ++r)
+                model.param->return_penalty(model.processedTable.value(r, id), attr, int(r),
+                                            model.processedTable.row(r), prior);
+        });
+
+        model.param->init_tf_idf(model.processed.columns);
+        run_bench("return_penalty_test", {{"rows", long(n)}, {"cardinality", long(card)}}, "cell", cells, [&]() {
+            for (size_t r = 0; r < cells; ++r)
+                model.param->return_penalty_test(model.processedTable.value(r, id), attr, int(r),
+                                                 model.processedTable.row(r), prior, model.processed.columns);
+        });
+
+        ofstream null_out("/dev/null");
+        streambuf* saved = cout.rdbuf(null_out.rdbuf());
+        Inference inference(model.dirtyTable, model.processedTable, model.snapshot, model.types,
+                            model.param, "PIPD", 1, 1, 1.0, false);
+        cout.rdbuf(saved);
+        const size_t rows = 256;
+        vector<ValueCode> out(model.dirtyTable.num_attrs());
+        run_bench("repair_row", {{"rows", long(n)}, {"cardinality", long(card)}}, "row", rows, [&]() {
+            for (size_t r = 0; r < rows; ++r)
+                inference.repair_row(model.dirtyTable.row(r), out.data(), int(r));
+        });
+    }
+}
+
+static void bench_dataset()
+{
+    for (size_t n : {1000, 10000}) {
+        DataFrame df = synthetic(n, 100);
+        char path[] = "/tmp/bclean_benchXXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0) {
+            cerr << "Cannot create a temporary file" << endl;
+            return;
+        }
+        close(fd);
+        {
+            ofstream csv(path);
+            for (size_t a = 0; a < df.columns.size(); ++a)
+                csv << (a ? "," : "") << df.columns[a];
+            csv << "\n";
+            for (const auto& row : df.rows) {
+                for (size_t a = 0; a < row.size(); ++a)
+                    csv << (a ? "," : "") << row[a];
+                csv << "\n";
+            }
+        }
+
+        Dataset loader;
+        run_bench("get_data", {{"rows", long(n)}}, "row", n, [&]() { loader.get_data(path); });
+        auto types = attr_types(df);
+        run_bench("pre_process_data", {{"rows", long(n)}}, "row", n, [&]() { loader.pre_process_data(df, types); });
+        // Statistics counted straight from the candidate cursor, with no
+        // preprocessed DataFrame in between
+        DataFrame no_rows;
+        for (const auto& kv : types)
+            no_rows.columns.push_back(kv.first);
+        run_bench("candidate_statistics", {{"rows", long(n)}}, "row", n, [&]() {
+            Compensative c(no_rows, types);
+            CandidateCursor rows = loader.candidate_rows(df, types);
+            c.add_rows(rows);
+        });
+        remove(path);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    for (int k = 1; k < argc; ++k) {
+        string arg = argv[k];
+        if (arg == "--filter" && k + 1 < argc)
+            g_options.filter = argv[++k];
+        else if (arg == "--min-time" && k + 1 < argc)
+            g_options.min_time = atof(argv[++k]);
+        else if (arg == "--out" && k + 1 < argc)
+            g_options.out = argv[++k];
+        else if (arg == "--counters")
+            g_options.counters = true;
+        else {
+            cerr << "usage: " << argv[0] << " [--filter name] [--min-time seconds] [--out file.json] [--counters]" << endl;
+            return 1;
+        }
+    }
+    alloc::set_tracking(true);
+    if (g_options.counters) {
+        g_counters = make_unique<PerfCounters>();
+        if (!g_counters->available()) {
+            cerr << "Hardware counters unavailable (" << g_counters->error() << "), timing only" << endl;
+            g_counters.reset();
+        }
+    }
+
+    bench_strings();
+    bench_compensative();
+    bench_structure();
+    bench_scoring();
+    bench_dataset();
+
+    if (g_options.out.empty()) {
+        write_json(cout);
+    } else {
+        ofstream out(g_options.out);
+        if (!out.is_open()) {
+            cerr << "Cannot write " << g_options.out << endl;
+            return 1;
+        }
+        write_json(out);
+    }
+    return 0;
+}
@@ -0,0 +1,291 @@
+// Synthetic dirty-data generator for scale testing. Writes a clean CSV, the
+// same rows with planted errors, and a UC JSON file describing the columns:
+//
+//   ./gen_dirty out_dir [--rows N] [--cols M] [--card K[,K...]] [--seed S]
+//               [--fd R] [--strength P] [--zipf S]
+//               [--typo R] [--null R] [--swap R] [--format R]
+//
+// out_dir/clean.csv, out_dir/dirty.csv and out_dir/uc.json use the layout
+// of data/ and json/ (an index column first), so that
+//   ./beers out_dir/dirty.csv out_dir/clean.csv out_dir/uc.json
+// runs on them. Rows are generated and written one at a time, so memory
+// does not grow with N.
+//
+// Column 0 is drawn from a Zipf distribution over its domain. Every other
+// column j has a parent among the earlier columns: with probability --fd
+// it is a functional dependency (the value is a fixed function of the
+// parent's), otherwise the function is followed with probability
+// --strength and the value is drawn from the column's own Zipf
+// distribution the rest of the time. Every fourth column is Numerical.
+//
+// Each cell gets at most one error, with these per-cell rates: --typo
+// (one edit: substitution, insertion, deletion or transposition), --null
+// (empty cell), --swap (exchanged with the next column's value) and
+// --format (Numerical values get a unit suffix, Categorical ones are
+// upper-cased).
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+struct GenOptions {
+    string out_dir;
+    size_t rows = 100000;
+    size_t cols = 8;
+    vector<size_t> cards = {20, 100, 1000};   // cycled over the columns
+    uint64_t seed = 42;
+    double fd = 0.5;
+    double strength = 0.8;
+    double zipf = 1.0;
+    double typo = 0.01;
+    double null_rate = 0.005;
+    double swap = 0.005;
+    double format = 0.005;
+};
+
+struct Column {
+    string name;
+    bool numerical = false;
+    size_t card = 0;
+    int parent = -1;
+    bool fd = false;
+    vector<uint32_t> mapping;   // parent value -> this column's value
+    vector<double> cdf;         // Zipf over the domain
+};
+
+static const char* const kSyllables[] = {"ka", "lo", "mi", "ne", "ru", "sa", "to", "vi",
+                                          "be", "da", "fu", "go", "ha", "ji", "po", "ze"};
+
+// Value k of a Categorical column: k spelled in syllables (at least three,
+// so that one typo rarely makes another valid value), capitalized
+static string categorical_value(size_t k)
+{
+    string s;
+    size_t rest = k;
+    for (int n = 0; n < 3 || rest > 0; ++n) {
+        s += kSyllables[rest % 16];
+        rest /= 16;
+    }
+    s[0] = char(toupper(s[0]));
+    return s;
+}
+
+static string value_text(const Column& c, uint32_t k)
+{
+    if (c.numerical)
+        return to_string(10 + size_t(k) * 3);
+    return categorical_value(k);
+}
+
+static uint32_t draw(const Column& c, mt19937_64& rng)
+{
+    double u = uniform_real_distribution<double>(0.0, 1.0)(rng);
+    return uint32_t(min(size_t(lower_bound(c.cdf.begin(), c.cdf.end(), u) - c.cdf.begin()), c.card - 1));
+}
+
+static vector<Column> make_columns(const GenOptions& opt, mt19937_64& rng)
+{
+    vector<Column> cols(opt.cols);
+    for (size_t j = 0; j < cols.size(); ++j) {
+        Column& c = cols[j];
+        c.name = "c" + to_string(j);
+        c.numerical = j % 4 == 3;
+        c.card = max<size_t>(opt.cards[j % opt.cards.size()], 1);
+
+        c.cdf.resize(c.card);
+        double sum = 0.0;
+        for (size_t k = 0; k < c.card; ++k)
+            c.cdf[k] = (sum += 1.0 / pow(double(k + 1), opt.zipf));
+        for (double& v : c.cdf)
+            v /= sum;
+
+        if (j == 0)
+            continue;
+        // Mostly the previous column, so that chains form
+        c.parent = (rng() % 4 == 0) ? int(rng() % j) : int(j - 1);
+        c.fd = uniform_real_distribution<double>(0.0, 1.0)(rng) < opt.fd;
+        c.mapping.resize(cols[c.parent].card);
+        for (auto& m : c.mapping)
+            m = uint32_t(rng() % c.card);
+    }
+    return cols;
+}
+
+static string typo(const string& s, mt19937_64& rng)
+{
+    static const string letters = "abcdefghijklmnopqrstuvwxyz";
+    static const string digits = "0123456789";
+    const bool numeric = !s.empty() && isdigit((unsigned char)s[0]);
+    const string& alphabet = numeric ? digits : letters;
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        string t = s;
+        size_t pos = t.empty() ? 0 : rng() % t.size();
+        switch (rng() % 4) {
+        case 0: if (!t.empty()) t[pos] = alphabet[rng() % alphabet.size()]; break;
+        case 1: t.insert(t.begin() + pos, alphabet[rng() % alphabet.size()]); break;
+        case 2: if (t.size() > 1) t.erase(pos, 1); break;
+        default: if (t.size() > 1) swap(t[pos], t[(pos + 1) % t.size()]); break;
+        }
+        if (t != s)
+            return t;
+    }
+    return s + alphabet[rng() % alphabet.size()];
+}
+
+static string format_error(const Column& c, const string& s)
+{
+    if (c.numerical)
+        return s + ".0 oz";
+    string t = s;
+    transform(t.begin(), t.end(), t.begin(), [](unsigned char ch) { return char(toupper(ch)); });
+    return t == s ? " " + s : t;
+}
+
+static void write_uc(const vector<Column>& cols, ostream& out)
+{
+    out << "{\n";
+    for (size_t j = 0; j < cols.size(); ++j) {
+        const Column& c = cols[j];
+        out << "    \"" << c.name << "\": {\n";
+        if (c.numerical) {
+            out << "        \"type\": \"Numerical\",\n"
+                << "        \"min_length\": " << value_text(c, 0) << ",\n"
+                << "        \"max_length\": " << value_text(c, uint32_t(c.card - 1)) << ",\n";
+        } else {
+            out << "        \"type\": \"Categorical\",\n"
+                << "        \"min_length\": " << categorical_value(0).size() << ",\n"
+                << "        \"max_length\": " << categorical_value(c.card - 1).size() << ",\n";
+        }
+        out << "        \"AllowNull\": \"N\",\n"
+            << "        \"repairable\": \"Y\",\n"
+            << "        \"pattern\": " << (c.numerical ? "\"^\\\\d+$\"" : "\"^[A-Z][a-z]+$\"") << "\n"
+            << "    }" << (j + 1 < cols.size() ? ",\n" : "\n");
+    }
+    out << "}\n";
+}
+
+static bool parse_args(int argc, char* argv[], GenOptions& opt)
+{
+    for (int k = 1; k < argc; ++k) {
+        string arg = argv[k];
+        if (arg.rfind("--", 0) != 0) {
+            opt.out_dir = arg;
+            continue;
+        }
+        if (k + 1 >= argc)
+            return false;
+        string value = argv[++k];
+        if (arg == "--rows") opt.rows = strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "--cols") opt.cols = strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "--seed") opt.seed = strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "--fd") opt.fd = atof(value.c_str());
+        else if (arg == "--strength") opt.strength = atof(value.c_str());
+        else if (arg == "--zipf") opt.zipf = atof(value.c_str());
+        else if (arg == "--typo") opt.typo = atof(value.c_str());
+        else if (arg == "--null") opt.null_rate = atof(value.c_str());
+        else if (arg == "--swap") opt.swap = atof(value.c_str());
+        else if (arg == "--format") opt.format = atof(value.c_str());
+        else if (arg == "--card") {
+            opt.cards.clear();
+            stringstream ss(value);
+            string item;
+            while (getline(ss, item, ','))
+                opt.cards.push_back(strtoull(item.c_str(), nullptr, 10));
+        } else
+            return false;
+    }
+    return !opt.out_dir.empty() && opt.cols > 0 && !opt.cards.empty();
+}
+
+int main(int argc, char* argv[])
+{
+    GenOptions opt;
+    if (!parse_args(argc, argv, opt)) {
+        cerr << "usage: " << argv[0] << " out_dir [--rows N] [--cols M] [--card K[,K...]] [--seed S]\n"
+             << "       [--fd R] [--strength P] [--zipf S] [--typo R] [--null R] [--swap R] [--format R]" << endl;
+        return 1;
+    }
+
+    ofstream clean(opt.out_dir + "/clean.csv"), dirty(opt.out_dir + "/dirty.csv"), uc(opt.out_dir + "/uc.json");
+    if (!clean.is_open() || !dirty.is_open() || !uc.is_open()) {
+        cerr << "Cannot write to " << opt.out_dir << endl;
+        return 1;
+    }
+
+    mt19937_64 rng(opt.seed);
+    const vector<Column> cols = make_columns(opt, rng);
+    write_uc(cols, uc);
+
+    clean << "index";
+    dirty << "index";
+    for (const auto& c : cols) {
+        clean << "," << c.name;
+        dirty << "," << c.name;
+    }
+    clean << "\n";
+    dirty << "\n";
+
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    vector<uint32_t> codes(cols.size());
+    vector<string> truth(cols.size()), noisy(cols.size());
+    vector<char> touched(cols.size());
+    size_t errors[4] = {0, 0, 0, 0};
+    for (size_t r = 0; r < opt.rows; ++r) {
+        for (size_t j = 0; j < cols.size(); ++j) {
+            const Column& c = cols[j];
+            if (c.parent < 0 || (!c.fd && unit(rng) >= opt.strength))
+                codes[j] = draw(c, rng);
+            else
+                codes[j] = c.mapping[codes[c.parent]];
+            truth[j] = value_text(c, codes[j]);
+        }
+
+        noisy = truth;
+        fill(touched.begin(), touched.end(), 0);
+        for (size_t j = 0; j < cols.size(); ++j) {
+            if (touched[j])
+                continue;
+            double u = unit(rng);
+            if ((u -= opt.typo) < 0) {
+                noisy[j] = typo(truth[j], rng);
+                errors[0]++;
+            } else if ((u -= opt.null_rate) < 0) {
+                noisy[j].clear();
+                errors[1]++;
+            } else if ((u -= opt.swap) < 0) {
+                if (j + 1 < cols.size() && truth[j] != truth[j + 1]) {
+                    swap(noisy[j], noisy[j + 1]);
+                    touched[j + 1] = 1;
+                    errors[2] += 2;
+                }
+            } else if ((u -= opt.format) < 0) {
+                noisy[j] = format_error(cols[j], truth[j]);
+                errors[3]++;
+            }
+            touched[j] = 1;
+        }
+
+        clean << r + 1;
+        dirty << r + 1;
+        for (size_t j = 0; j < cols.size(); ++j) {
+            clean << "," << truth[j];
+            dirty << "," << noisy[j];
+        }
+        clean << "\n";
+        dirty << "\n";
+    }
+
+    cerr << opt.rows << " rows x " << cols.size() << " columns written to " << opt.out_dir << endl;
+    cerr << "errors: typo " << errors[0] << ", null " << errors[1] << ", swap " << errors[2]
+         << ", format " << errors[3] << endl;
+    for (size_t j = 1; j < cols.size(); ++j)
+        cerr << "  " << cols[cols[j].parent].name << (cols[j].fd ? " -> " : " ~> ") << cols[j].name << endl;
+    return 0;
+}
@@ -0,0 +1,130 @@
+// Client stand-in for repair_service: replays the rows of a CSV file over
+// the Unix socket from several concurrent connections and reports per-row
+// latency percentiles and throughput.
+//
+//   ./repair_client /tmp/bclean.sock data/dirty.csv [connections] [rounds]
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "../dataset.h"
+using namespace std;
+
+static int connect_to(const string& path)
+{
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        cerr << "Cannot connect to " << path << ": " << strerror(errno) << endl;
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Sends one line and reads one line back
+static bool round_trip(int fd, const string& request, string& buffer, string& reply)
+{
+    string msg = request + "\n";
+    if (::write(fd, msg.data(), msg.size()) != (ssize_t)msg.size())
+        return false;
+    size_t nl;
+    char chunk[4096];
+    while ((nl = buffer.find('\n')) == string::npos) {
+        ssize_t got = ::read(fd, chunk, sizeof(chunk));
+        if (got <= 0)
+            return false;
+        buffer.append(chunk, got);
+    }
+    reply = buffer.substr(0, nl);
+    buffer.erase(0, nl + 1);
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        cerr << "usage: " << argv[0] << " SOCKET CSV [connections] [rounds]" << endl;
+        return 1;
+    }
+    string socket_path = argv[1];
+    int connections = argc > 3 ? stoi(argv[3]) : 4;
+    int rounds = argc > 4 ? stoi(argv[4]) : 5;
+
+    Dataset dataset;
+    DataFrame df = dataset.get_data(argv[2]);
+
+    // Project the CSV onto the service's column order
+    int fd = connect_to(socket_path);
+    if (fd < 0)
+        return 1;
+    string buffer, header;
+    round_trip(fd, "?columns", buffer, header);
+    ::close(fd);
+    vector<string> columns = Dataset::split_line(header);
+    unordered_map<string, size_t> index;
+    for (size_t j = 0; j < df.columns.size(); ++j)
+        index[df.columns[j]] = j;
+
+    vector<string> requests;
+    for (const auto& row : df.rows) {
+        string line;
+        for (size_t a = 0; a < columns.size(); ++a) {
+            auto it = index.find(columns[a]);
+            line += (a ? "," : "") + (it != index.end() ? row[it->second] : string());
+        }
+        requests.push_back(line);
+    }
+
+    vector<double> latencies;
+    mutex latency_mutex;
+    auto start = chrono::steady_clock::now();
+
+    vector<thread> clients;
+    for (int c = 0; c < connections; ++c) {
+        clients.emplace_back([&, c]() {
+            int conn = connect_to(socket_path);
+            if (conn < 0)
+                return;
+            string buf, reply;
+            vector<double> local;
+            for (int r = 0; r < rounds; ++r) {
+                for (size_t i = c; i < requests.size(); i += connections) {
+                    auto t0 = chrono::steady_clock::now();
+                    if (!round_trip(conn, requests[i], buf, reply))
+                        break;
+                    local.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count());
+                }
+            }
+            ::close(conn);
+            lock_guard<mutex> lock(latency_mutex);
+            latencies.insert(latencies.end(), local.begin(), local.end());
+        });
+    }
+    for (auto& t : clients)
+        t.join();
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (latencies.empty()) {
+        cerr << "No replies received" << endl;
+        return 1;
+    }
+    sort(latencies.begin(), latencies.end());
+    auto pct = [&](double p) { return latencies[min(latencies.size() - 1, size_t(p * latencies.size()))]; };
+    cout << latencies.size() << " rows over " << connections << " connections in " << seconds << " s ("
+         << latencies.size() / seconds << " rows/s)" << endl;
+    cout << "latency us: p50=" << pct(0.50) << " p90=" << pct(0.90) << " p99=" << pct(0.99)
+         << " max=" << latencies.back() << endl;
+    return 0;
+}
@@ -0,0 +1,43 @@
+// Repair daemon for the beers sample: learns the model once from the dirty
+// data, then answers one CSV row per line.
+//
+//   ./repair_service                 # read rows from stdin
+//   ./repair_service /tmp/bclean.sock  # serve a Unix domain socket
+//
+// Send "?columns" to get the column order of requests and responses.
+#include <iostream>
+#include <string>
+#include "../dataset.h"
+#include "../include/UserConstraints.h"
+#include "../include/RepairService.h"
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    string dirty_path = "data/dirty.csv";
+    string json_path = "json/beers.json";
+
+    Dataset dataset;
+    DataFrame dirty_data = dataset.get_data(dirty_path);
+
+    UC uc(dirty_data);
+    uc.build_from_json(json_path);
+    map<string, AttrInfo> attr_type = uc.get_attr_info();
+    dirty_data = dataset.get_real_data(dirty_data, attr_type);
+
+    // Model-learning chatter goes to stderr so stdout carries only answers
+    streambuf* saved = cout.rdbuf(cerr.rdbuf());
+    ServiceOptions options;
+    options.infer_strategy = "Compensative";
+    options.tuple_prun = 0.5;
+    RepairService service(dirty_data, attr_type, options);
+
+    if (argc == 2) {
+        bool ok = service.serve_unix(argv[1]);
+        cout.rdbuf(saved);
+        return ok ? 0 : 1;
+    }
+    cout.rdbuf(saved);
+    service.serve_stream(cin, cout);
+    return 0;
+}
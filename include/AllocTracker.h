@@ -0,0 +1,33 @@
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Heap accounting through the global operator new/delete, which the
+// library replaces (src/AllocTracker.cpp). Counting is off until
+// set_tracking(true); until then each allocation costs one relaxed load.
+// Sizes are what malloc hands out (malloc_usable_size), so that freed
+// bytes match allocated ones. Memory allocated before tracking started
+// and freed afterwards makes live_bytes drop below zero.
+namespace alloc {
+
+struct Counters {
+    uint64_t allocs = 0;
+    uint64_t frees = 0;
+    uint64_t bytes = 0;            // allocated in total
+    int64_t live_bytes = 0;        // allocated and not yet freed
+    int64_t peak_live_bytes = 0;   // highest live_bytes since reset_peak()
+};
+
+void set_tracking(bool on);
+bool tracking();
+
+Counters snapshot();
+
+// Starts a new peak from the current live bytes
+void reset_peak();
+
+}  // namespace alloc
+
+#endif // ALLOC_TRACKER_H
@@ -8,6 +8,8 @@
 #include <unordered_map>
 #include "dataset.h"
 
+struct CodedColumns;
+
 // Directed edge
 struct Edge
 {
@@ -28,6 +30,45 @@ struct BNGraph
     std::map<std::string, std::set<std::string>> adjacency_list;
 };
 
+// Search settings for the learners other than 'appr' and 'fix'
+struct StructureOptions
+{
+    // 'hc': score-based hill climbing
+    std::string score = "bic";          // "bic" or "bdeu"
+    double equivalent_sample_size = 10; // BDeu prior strength
+    int max_indegree = 2;
+    int max_iter = 1000;                // moves per climb
+    int tabu_length = 10;               // 0 stops at the first local optimum
+    int restarts = 0;                   // random restarts from the best graph
+    int restart_moves = 0;              // perturbation per restart; 0 = one per attribute
+    unsigned seed = 0;
+
+    // 'chowliu': tree root; empty picks the attribute with the most MI to
+    // its tree neighbours
+    std::string root;
+
+    // 'pc': conditional-independence tests
+    std::string ci_test = "g2";         // "g2" or "chi2"
+    double alpha = 0.05;                // independence when p > alpha
+    int max_cond_size = 3;              // largest conditioning set tried
+
+    // Learn from a single-pass sample when the data has more rows than
+    // sample_size (0 = always use every row). Borderline MI edges are
+    // re-checked on a larger nested sample (0 = 4 x sample_size).
+    size_t sample_size = 0;
+    size_t recheck_sample_size = 0;
+    std::string sample_stratify;        // column for a stratified sample
+};
+
+// MI of one attribute pair with a 95% confidence interval; only filled in
+// when structure learning ran on a sample
+struct MIInterval
+{
+    std::string a, b;
+    double mi, low, high;
+    bool rechecked;                     // mi comes from the larger sample
+};
+
 // Result of get_bn()
 struct BNResult
 {
@@ -38,28 +79,54 @@ struct BNResult
 class BNStructure
 {
 public:
+    // A non-empty model_path loads the network from a model file (see
+    // ModelFile.h) instead of learning it; model_save_path writes the
+    // learned network, with its CPT counts and dictionaries, to one
     BNStructure(const DataFrame &data,
                 const std::string &model_path,
                 const std::string &model_choice,
                 const std::vector<Edge> &fix_edge,
-                const std::string &model_save_path = "");
+                const std::string &model_save_path = "",
+                int num_worker = 1,
+                const StructureOptions &options = StructureOptions());
 
     void print_bn_result(const BNResult &result);
     void print_graph(const BNGraph &graph);
 
     BNResult get_bn();
 
+    // Larger sample for re-checking borderline MI when data is itself a
+    // sample, e.g. one taken while streaming the input
+    void set_recheck_data(const DataFrame &rows) { recheck_data = rows; }
+
+    const std::vector<MIInterval> &mi_intervals() const { return intervals; }
+
+    // Edges of the greedy mutual-information learner ('appr')
+    std::vector<Edge> get_rel(const DataFrame &data);
+
 private:
     DataFrame data;
     std::string model_path;
     std::string model_choice;
     std::string model_save_path;
     std::vector<Edge> fix_edge;
+    int num_worker;   // threads used for pairwise statistics and scoring
+    StructureOptions options;
+    DataFrame recheck_data;
+    std::vector<MIInterval> intervals;
 
     BNGraph model;
     std::unordered_map<std::string, BNGraph> model_dict;
 
-    std::vector<Edge> get_rel(const DataFrame &data);
+    std::vector<Edge> get_hill_climb(const DataFrame &data, const std::vector<std::string> &attrs);
+    std::vector<Edge> get_chow_liu(const DataFrame &data, const std::vector<std::string> &attrs);
+    std::vector<Edge> get_pc(const DataFrame &data, const std::vector<std::string> &attrs);
+    std::vector<std::pair<int, int>> fixed_edge_ids(const std::vector<std::string> &attrs);
+    static std::vector<std::string> attribute_names(const DataFrame &data);
+
+    // Symmetric m x m matrix of pairwise mutual information, optionally
+    // with the variance of each estimate
+    std::vector<double> pairwise_mi(const CodedColumns &cols, std::vector<double> *variance = nullptr);
 };
 
 #endif // BNStructure_H
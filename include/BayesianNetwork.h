@@ -3,18 +3,40 @@
 
 #include <unordered_map>
 #include <string>
+#include <vector>
 
 class BayesianNetwork {
 public:
-    // The probabilityTable stores, for each attribute, a mapping from candidate values to their probabilities.
-    std::unordered_map<std::string, std::unordered_map<std::string, double>> probabilityTable;
+    // Probability of values never added
+    static constexpr double kUnseenProbability = 1e-9;
 
     // Adds or updates the probability for a given attribute-value pair.
     void addProbability(const std::string& attribute, const std::string& value, double probability);
 
     // Retrieves the probability for a given attribute-value pair.
     // If the pair isn't found, returns a small default value to avoid zero probabilities.
-    double getProbability(const std::string& attribute, const std::string& value);
+    double getProbability(const std::string& attribute, const std::string& value) const;
+
+    // Interned ids: attributes and, per attribute, values are numbered in
+    // the order they were first added. -1 if never added.
+    int attributeId(const std::string& attribute) const;
+    int valueId(int attribute, const std::string& value) const;
+
+    // log P(value) by id; log(kUnseenProbability) for value -1
+    double logProbability(int attribute, int value) const;
+
+    // log P(value) of one attribute's values, indexed by value id
+    const std::vector<double>& logProbabilities(int attribute) const { return tables[attribute].logProb; }
+
+private:
+    struct Table {
+        std::unordered_map<std::string, int> ids;
+        std::vector<double> prob;
+        std::vector<double> logProb;
+    };
+
+    std::unordered_map<std::string, int> attributeIds;
+    std::vector<Table> tables;
 };
 
-#endif // BAYESIANNETWORK_H
\ No newline at end of file
+#endif // BAYESIANNETWORK_H
@@ -0,0 +1,61 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Lock-free single-producer / single-consumer ring buffer connecting two
+// pipeline stages. push() waits while the queue is full, which is what
+// throttles a fast producer to the pace of its consumer.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : slots_(capacity + 1) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Producer side; waits for a free slot
+    void push(T item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t next = advance(tail);
+        while (next == head_.load(std::memory_order_acquire))
+            backoff();
+        slots_[tail] = std::move(item);
+        tail_.store(next, std::memory_order_release);
+    }
+
+    // Producer side; no more items will be pushed
+    void close() { closed_.store(true, std::memory_order_release); }
+
+    // Consumer side; waits for an item. Returns false once the queue is
+    // closed and drained.
+    bool pop(T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        while (head == tail_.load(std::memory_order_acquire)) {
+            if (closed_.load(std::memory_order_acquire) &&
+                head == tail_.load(std::memory_order_acquire))
+                return false;
+            backoff();
+        }
+        item = std::move(slots_[head]);
+        head_.store(advance(head), std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const { return slots_.size() - 1; }
+
+private:
+    size_t advance(size_t i) const { return i + 1 == slots_.size() ? 0 : i + 1; }
+    static void backoff() { std::this_thread::yield(); }
+
+    std::vector<T> slots_;
+    alignas(64) std::atomic<size_t> head_{0};  // next slot to pop
+    alignas(64) std::atomic<size_t> tail_{0};  // next slot to fill
+    std::atomic<bool> closed_{false};
+};
+
+#endif // BOUNDED_QUEUE_H
@@ -31,7 +31,9 @@ public:
     void setDomain(const std::string& attribute, const std::vector<std::string>& values);
 
     // Clean the dataset by applying a simplified Bayesian repair logic.
-    DataFrameCleaner cleanData();
+    // The best candidate of an attribute does not depend on the row, so it
+    // is found once per attribute; rows are then patched in parallel.
+    DataFrameCleaner cleanData(int num_worker = 1);
 };
 
 #endif // CLEANER_H
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef COLUMN_PROFILE_H
+#define COLUMN_PROFILE_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "PatternDiscovery.h"  // ShapeHistogram
+
+struct DataFrame;
+
+// HyperLogLog sketch of the number of distinct values, 2^kPrecision
+// one-byte registers (about 1.6% standard error)
+class HyperLogLog {
+public:
+    static const int kPrecision = 12;
+
+    HyperLogLog() : registers(size_t(1) << kPrecision, 0) {}
+
+    void add(const std::string& value);
+    void merge(const HyperLogLog& other);
+    double estimate() const;
+
+private:
+    std::vector<uint8_t> registers;
+};
+
+// Statistics of one column from a single scan. Empty cells and "A Null
+// Cell" count as nulls and take part in nothing else.
+struct ColumnProfile {
+    size_t values = 0;                 // cells scanned
+    size_t nulls = 0;
+
+    // Values starting with a number (as std::stod reads them): their count,
+    // smallest and largest, and the number as written
+    size_t numeric = 0;
+    double min_number = HUGE_VAL;
+    double max_number = -HUGE_VAL;
+    std::string min_number_text;
+    std::string max_number_text;
+
+    // Shortest and longest non-null value, first seen of each length
+    size_t min_length = 0;
+    size_t max_length = 0;
+    std::string shortest;
+    std::string longest;
+
+    HyperLogLog distinct;
+
+    // Most frequent values, most frequent first, by the Space-Saving
+    // algorithm: counts may be overestimated by at most values / capacity
+    std::vector<std::pair<std::string, size_t>> top;
+
+    // Character-class shapes, for pattern discovery
+    ShapeHistogram shapes;
+
+    size_t non_null() const { return values - nulls; }
+    double distinct_estimate() const { return distinct.estimate(); }
+};
+
+// Profiles every column of data in one pass per column, the columns spread
+// over num_worker threads. With sample_size > 0, larger tables are
+// profiled on sample_size evenly spaced rows. top_k heavy hitters are kept.
+std::vector<ColumnProfile> profile_columns(const DataFrame& data,
+                                           int num_worker = 1,
+                                           size_t sample_size = 0,
+                                           size_t top_k = 10);
+
+#endif // COLUMN_PROFILE_H
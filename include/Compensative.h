@@ -11,6 +11,9 @@
 #include <vector>
 #include <map>
 #include "dataset.h"  // DataFrame and AttrInfo
+#include "InternPool.h"
+
+struct ModelSnapshot;
 
 using std::string;
 using std::vector;
@@ -18,7 +21,8 @@ using std::unordered_map;
 using std::map;
 
 using Row = unordered_map<string, string>;
-using Data = vector<Row>;
+// Rows of interned values (InternPool::global()), one cell per attribute
+using Data = vector<vector<InternId>>;
 // Update AttrType to match BayesianClean’s attribute type
 using AttrType = map<string, AttrInfo>;
 
@@ -28,6 +32,15 @@ public:
 
     void build();
 
+    // Appends a chunk of rows (columns as in the constructor's DataFrame)
+    // and counts them into the statistics. Feeding the rows chunk by chunk
+    // gives the same statistics as build() over all of them.
+    void add_rows(const DataFrame& chunk);
+
+    // Same, reading the candidate rows straight from a cursor (e.g.
+    // Dataset::candidate_rows) instead of a preprocessed DataFrame
+    void add_rows(CandidateCursor& rows);
+
     // Getters for BayesianClean to use
     const unordered_map<string,
         unordered_map<string,
@@ -47,6 +60,12 @@ public:
         return Frequency_list;
     }
 
+    // Moves the statistics into model, leaving them empty here
+    void move_statistics_to(ModelSnapshot& model);
+
+    // Approximate heap bytes of the row copy and of each statistics map
+    map<string, size_t> memory_footprint() const;
+
     // -------- For debugging -----------
 
     // Print frequencyList: unordered_map<string, unordered_map<string, int>>
@@ -64,9 +83,17 @@ public:
 
 private:
     void occur_and_fre();
-    void correlate(int row_index, const string& attr_main);
+    void count_rows(size_t first);
+    void correlate(size_t row_index, size_t main, const vector<char>& valid);
     bool isValid(const string& attr, const string& value);
-
+    void append(const DataFrame& rows);
+    // Column of columns holding each of attrs, SIZE_MAX if absent
+    vector<size_t> source_of(const vector<string>& columns) const;
+    void append_row(const vector<string>& rowVec, const vector<size_t>& source, InternId empty);
+
+    // Attributes in the order the statistics are filled: the iteration
+    // order of a Row holding every column, which the rows used to be
+    vector<string> attrs;
     Data data;
     AttrType attrs_type;
 
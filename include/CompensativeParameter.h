@@ -8,6 +8,8 @@
 #include <memory>
 #include "dataset.h"      // For DataFrame, Row, AttrInfo
 #include "BNStructure.h"  // For BNGraph
+#include "EncodedTable.h" // For EncodedTable, RowSpan
+#include "ModelSnapshot.h" // For ModelSnapshotPtr
 
 using std::string;
 using std::vector;
@@ -20,63 +22,73 @@ using Row = unordered_map<string, string>;
 // Penalty computation
 class CompensativeParameter {
 public:
+    // domain, occurrence and the graph are read from model_snapshot, which is
+    // shared rather than copied
     CompensativeParameter(const map<string, AttrInfo>& attr_type,
-                          const unordered_map<string, unordered_map<string, int>>& domain,
-                          const unordered_map<string,
-                              unordered_map<string,
-                                  unordered_map<string,
-                                      unordered_map<string, double>>>>& occurrence,
-                          const BNGraph& model,
-                          const DataFrame& df);
+                          ModelSnapshotPtr model_snapshot,
+                          const EncodedTable& df);
 
     // Compute penalty scores for a given observed value (obs) for attribute (attr)
     unordered_map<string, double> return_penalty(const string& obs,
                                                    const string& attr,
                                                    int index,
-                                                   const Row& data_line,
+                                                   RowSpan data_line,
                                                    const vector<string>& prior);
 
     // TF-IDF–based variant for penalty scoring
     unordered_map<string, double> return_penalty_test(const string& obs,
                                                       const string& attr,
                                                       int index,
-                                                      const Row& data_line,
+                                                      RowSpan data_line,
                                                       const vector<string>& prior,
                                                       const vector<string>& attr_order);
 
     // Initialization of TF-IDF data
     void init_tf_idf(const vector<string>& attr_order);
 
+    // Turns the per-candidate [DEBUG] trace of return_penalty on or off
+    void set_debug(bool on) { debug = on; }
+
+    // Approximate heap bytes of the table and TF-IDF data; the shared
+    // statistics are counted by ModelSnapshot::memory_footprint()
+    map<string, size_t> memory_footprint() const;
+
+    // Lower-cased with spaces and '%' removed, the form values are compared in
+    static string canonical(const string& s);
+
+    // Compute Levenshtein distance (edit distance) between two strings
+    static int levenshtein_distance(const string& s1, const string& s2);
+
 private:
     map<string, AttrInfo> attr_type;
-    unordered_map<string, unordered_map<string, int>> domain;
-
+    ModelSnapshotPtr snapshot;
+    // Views into snapshot
+    const FrequencyList& domain;
     // Weighted co-occurrence counts
-    unordered_map<string,
-        unordered_map<string,
-            unordered_map<string,
-                unordered_map<string, double>>>> occurrence;
+    const OccurrenceList& occurrence;
     // BN model
-    BNGraph model;
+    const BNGraph& model;
 
-    // Dataset
-    DataFrame df;
+    // Dataset, encoded against the same schema as the rows passed in
+    EncodedTable df;
+    // Schema id of every attribute in attr_type, in attr_type order
+    vector<std::pair<string, int>> attr_ids;
 
     // Data structure to hold TF-IDF info
     struct TFIDFData {
         vector<string> combine_attrs;                   
+        vector<int> combine_ids;
         unordered_map<string, int> dic;   
         unordered_map<string, int> dic_idf;
     };
 
+    bool debug = true;
+
     // Map from an attribute name to its TF-IDF data
     unordered_map<string, std::shared_ptr<TFIDFData>> tf_idf;
 
     // ----------------- Helper Functions -----------------
 
-    // Compute Levenshtein distance (edit distance) between two strings
-    int levenshtein_distance(const string& s1, const string& s2);
-
     // Compute Euclidean (L2) norm of a vector
     double euclidean_norm(const vector<double>& vec);
 };
@@ -0,0 +1,87 @@
+#ifndef CONSTRAINT_DETECTOR_H
+#define CONSTRAINT_DETECTOR_H
+
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+#include "dataset.h"        // AttrInfo
+#include "EncodedTable.h"   // EncodedTable, ValueCode
+
+// Ways a value can break its attribute's constraints, as bit flags
+enum ViolationKind : uint8_t {
+    kNullViolation    = 1,   // null, and nulls are not allowed
+    kTypeViolation    = 2,   // Numerical, but does not start with a number
+    kRangeViolation   = 4,   // Numerical, outside [min, max]
+    kLengthViolation  = 8,   // other types, length outside [min, max]
+    kPatternViolation = 16   // pattern set, and not found in the value
+};
+
+// One attribute's constraints in the form the checks use: for Numerical
+// attributes min and max bound the value, for the others its length
+struct CompiledConstraint {
+    bool numeric = false;
+    bool allow_null = false;
+    double min = -HUGE_VAL;
+    double max = HUGE_VAL;
+    std::shared_ptr<const std::regex> pattern;   // null if none
+
+    static CompiledConstraint compile(const AttrInfo& info);
+
+    // ViolationKind bits of value, 0 if it satisfies every constraint
+    uint8_t check(const std::string& value) const;
+};
+
+// Per-cell violation bits of a table, one bitmap per attribute with 64
+// rows per word
+class ViolationBitmap {
+public:
+    ViolationBitmap() = default;
+    ViolationBitmap(size_t num_rows, size_t num_attrs);
+
+    bool test(size_t row, int attr) const
+    {
+        return (bits[attr][row >> 6] >> (row & 63)) & 1;
+    }
+    const std::vector<uint64_t>& column(int attr) const { return bits[attr]; }
+    std::vector<uint64_t>& column(int attr) { return bits[attr]; }
+
+    size_t num_rows() const { return rows; }
+    size_t count() const;   // violating cells
+
+private:
+    size_t rows = 0;
+    std::vector<std::vector<uint64_t>> bits;
+};
+
+// Compiles the constraints of every attribute in attr_type and evaluates
+// them over encoded tables. Every check depends on the value only, so it
+// runs once per dictionary code; a column is then flagged by looking its
+// codes up in that table.
+class ConstraintDetector {
+public:
+    ConstraintDetector() = default;
+    ConstraintDetector(const std::shared_ptr<EncodedSchema>& schema,
+                       const std::map<std::string, AttrInfo>& attr_type);
+
+    // Violating cells of table, the columns split over num_worker threads.
+    // Attributes without constraints are never flagged.
+    ViolationBitmap detect(const EncodedTable& table, int num_worker = 1);
+
+    // Violation bits of one code; codes added to the schema after the last
+    // detect() are checked directly. Safe to call from several threads.
+    uint8_t violations(int attr, ValueCode code) const;
+
+private:
+    void refresh_codes(int attr);
+
+    std::shared_ptr<EncodedSchema> schema;
+    std::vector<char> constrained;                // by attribute id
+    std::vector<CompiledConstraint> constraints;  // by attribute id
+    std::vector<std::vector<uint8_t>> code_bits;  // [attr][code]
+};
+
+#endif // CONSTRAINT_DETECTOR_H
@@ -0,0 +1,75 @@
+#ifndef CONTINGENCY_H
+#define CONTINGENCY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "dataset.h"  // DataFrame
+
+// Column-wise dictionary coding of a DataFrame for counting. Codes follow
+// the sorted order of the values, so walking codes in increasing order
+// visits values in the same order as a std::map<string, ...> would.
+struct CodedColumns {
+    size_t num_rows = 0;
+    std::vector<std::vector<uint32_t>> codes;     // [attr][row]
+    std::vector<std::vector<std::string>> values; // [attr][code]
+    std::vector<std::vector<int>> counts;         // marginal counts [attr][code]
+
+    static CodedColumns encode(const DataFrame& data);
+
+    size_t num_attrs() const { return codes.size(); }
+    size_t cardinality(size_t attr) const { return values[attr].size(); }
+};
+
+// Joint counts of two coded columns. Stored as a dense ci x cj array when
+// that is not much larger than the number of rows, and as a hash table of
+// the non-zero cells otherwise.
+class PairCounts {
+public:
+    PairCounts(const CodedColumns& cols, size_t i, size_t j);
+
+    bool dense() const { return is_dense; }
+
+    // Calls fn(code_i, code_j, count) for every non-zero cell in
+    // (code_i, code_j) order
+    template <typename Fn>
+    void for_each(Fn fn) const {
+        if (!is_dense) {
+            for (size_t k = 0; k < sparse_keys.size(); ++k)
+                fn(uint32_t(sparse_keys[k] >> 32), uint32_t(sparse_keys[k]), sparse_counts[k]);
+            return;
+        }
+        for (size_t a = 0; a < ci; ++a)
+            for (size_t b = 0; b < cj; ++b)
+                if (int c = cells[a * cj + b])
+                    fn(uint32_t(a), uint32_t(b), c);
+    }
+
+    // Dense tables are used up to max(kDenseRowFactor * rows, kDenseMinCells)
+    // cells, never beyond kDenseMaxCells
+    static const size_t kDenseRowFactor = 4;
+    static const size_t kDenseMinCells = 1 << 16;
+    static const size_t kDenseMaxCells = 1 << 24;
+
+private:
+    size_t ci, cj;
+    bool is_dense;
+    std::vector<int> cells;              // dense, row-major in code_i
+    std::vector<uint64_t> sparse_keys;   // sorted (code_i << 32 | code_j)
+    std::vector<int> sparse_counts;
+};
+
+// Mutual information of two coded columns, using the marginals cached in
+// cols. Symmetric up to floating-point summation order.
+double mutual_information(const CodedColumns& cols, size_t i, size_t j);
+
+// Plug-in MI with its asymptotic variance,
+// (sum p_ij * log(p_ij / (p_i p_j))^2 - MI^2) / n, for confidence
+// intervals when cols holds a sample
+struct MIEstimate {
+    double mi = 0.0;
+    double variance = 0.0;
+};
+MIEstimate mutual_information_estimate(const CodedColumns& cols, size_t i, size_t j);
+
+#endif // CONTINGENCY_H
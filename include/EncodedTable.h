@@ -0,0 +1,117 @@
+#ifndef ENCODED_TABLE_H
+#define ENCODED_TABLE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "dataset.h"  // DataFrame
+#include "InternPool.h"
+
+// Integer code of a cell value within its attribute's dictionary
+using ValueCode = std::uint32_t;
+constexpr ValueCode kNoCode = UINT32_MAX;
+
+// Distinct values of one attribute, numbered in order of first appearance.
+// The values themselves are held once in InternPool::global().
+class ValueDictionary {
+public:
+    // Returns the code of value, adding it if unseen
+    ValueCode encode(const std::string& value);
+
+    // Returns the code of value, or kNoCode if it was never encoded
+    ValueCode lookup(const std::string& value) const;
+
+    const std::string& decode(ValueCode code) const { return *values_[code]; }
+    size_t size() const { return values_.size(); }
+
+    // Forgets every value with a code >= size, e.g. values seen only in
+    // rows that have already been answered
+    void truncate(size_t size);
+
+    // Approximate heap bytes held (see MemoryFootprint.h)
+    size_t memory_footprint() const;
+
+private:
+    std::unordered_map<std::string_view, ValueCode> index_;   // views into the pool
+    std::vector<const std::string*> values_;
+};
+
+// Attribute order plus one dictionary per attribute. Tables that share a
+// schema share codes, so a code taken from one can be written into another.
+class EncodedSchema {
+public:
+    explicit EncodedSchema(const std::vector<std::string>& attrs);
+
+    size_t num_attrs() const { return attrs_.size(); }
+    const std::vector<std::string>& attrs() const { return attrs_; }
+    const std::string& attr_name(int id) const { return attrs_[id]; }
+
+    // Returns the id of an attribute, or -1 if it is not in the schema
+    int attr_id(const std::string& name) const;
+
+    ValueDictionary& dict(int id) { return dicts_[id]; }
+    const ValueDictionary& dict(int id) const { return dicts_[id]; }
+
+    // Approximate heap bytes held by the names and dictionaries
+    size_t memory_footprint() const;
+
+private:
+    std::vector<std::string> attrs_;
+    std::unordered_map<std::string, int> attrIndex_;
+    std::vector<ValueDictionary> dicts_;
+};
+
+// Read-only view of one encoded row: codes indexed by attribute id
+struct RowSpan {
+    const ValueCode* codes = nullptr;
+    size_t size = 0;
+
+    ValueCode operator[](size_t attr) const { return codes[attr]; }
+};
+
+// Row-major table of value codes, num_rows x num_attrs
+class EncodedTable {
+public:
+    explicit EncodedTable(std::shared_ptr<EncodedSchema> schema = nullptr);
+
+    // Encodes df by column name into the given schema. Attributes missing
+    // from df, and empty cells, are stored as null_value when it is non-empty.
+    static EncodedTable encode(const DataFrame& df,
+                               const std::shared_ptr<EncodedSchema>& schema,
+                               const std::string& null_value = "");
+
+    const std::shared_ptr<EncodedSchema>& schema() const { return schema_; }
+    size_t num_rows() const { return numRows_; }
+    size_t num_attrs() const { return schema_ ? schema_->num_attrs() : 0; }
+
+    RowSpan row(size_t i) const { return {cells_.data() + i * num_attrs(), num_attrs()}; }
+    ValueCode* row_data(size_t i) { return cells_.data() + i * num_attrs(); }
+
+    ValueCode code(size_t row, int attr) const { return cells_[row * num_attrs() + attr]; }
+    const std::string& value(size_t row, int attr) const { return schema_->dict(attr).decode(code(row, attr)); }
+
+    // Appends one row given in schema attribute order
+    void append_row(const std::vector<std::string>& values);
+
+    // Appends the rows of df, encoded as by encode()
+    void append(const DataFrame& df, const std::string& null_value = "");
+
+    // Copies rows [begin, end) into a table sharing this schema
+    EncodedTable slice(size_t begin, size_t end) const;
+
+    // Materializes the table back into strings
+    DataFrame decode() const;
+
+    // Heap bytes of the codes; the shared schema is not counted
+    size_t memory_footprint() const { return cells_.capacity() * sizeof(ValueCode); }
+
+private:
+    std::shared_ptr<EncodedSchema> schema_;
+    std::vector<ValueCode> cells_;
+    size_t numRows_ = 0;
+};
+
+#endif // ENCODED_TABLE_H
@@ -0,0 +1,100 @@
+#ifndef HILL_CLIMB_H
+#define HILL_CLIMB_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "BNStructure.h"  // StructureOptions
+#include "Contingency.h"  // CodedColumns
+
+class ThreadPool;
+
+// Decomposable network score (BIC or BDeu) of one node given a parent set.
+// Family scores are cached by parent set, so a family is counted over the
+// data at most once per search. score() is safe to call from several
+// threads.
+class FamilyScorer {
+public:
+    enum class Kind { BIC, BDeu };
+
+    FamilyScorer(const CodedColumns& cols, Kind kind, double equivalent_sample_size);
+
+    // parents must be sorted
+    double score(int node, const std::vector<int>& parents);
+
+    size_t cached_families() const;
+
+private:
+    double compute(int node, const std::vector<int>& parents) const;
+
+    const CodedColumns& cols;
+    Kind kind;
+    double ess;
+    std::vector<std::unique_ptr<std::mutex>> locks;        // one per node
+    std::vector<std::map<std::vector<int>, double>> cache; // [node][parents]
+};
+
+// Greedy search over DAGs with add / remove / reverse moves, a tabu list
+// and optional random restarts.
+//
+// delta[u * m + v] holds the score change of toggling u in the parent set
+// of v. A move only changes the families of its endpoints, so after each
+// move only those one or two columns of delta are recomputed; reversals are
+// priced from two cached entries. Acyclicity is checked by reachability,
+// and only for moves that would beat the current best.
+class HillClimbSearch {
+public:
+    HillClimbSearch(const CodedColumns& cols, const StructureOptions& options, int num_worker);
+    ~HillClimbSearch();
+
+    // Returns the best DAG found as (parent, child) pairs. Required edges
+    // are in the starting graph and are never removed or reversed.
+    std::vector<std::pair<int, int>> run(const std::vector<std::pair<int, int>>& required);
+
+    double best_score() const { return best_total; }
+    size_t moves() const { return applied_moves; }
+    size_t cached_families() const { return scorer.cached_families(); }
+
+private:
+    enum MoveType { Add, Remove, Reverse };
+    struct Move {
+        MoveType type;
+        int u, v;           // edge u -> v (before the move for Remove / Reverse)
+        double delta;
+    };
+
+    void climb();
+    bool find_best(Move& best) const;
+    bool legal(const Move& mv) const;
+    void apply(const Move& mv);
+    void perturb(size_t count);
+    void refresh_column(int v);
+    void refresh_all();
+    bool reaches(int from, int to, int skip_u = -1, int skip_v = -1) const;
+    bool is_tabu(const Move& mv) const;
+    double total() const;
+
+    bool has_edge(int u, int v) const { return edge[size_t(u) * m + v] != 0; }
+    bool is_required(int u, int v) const { return required_edge[size_t(u) * m + v] != 0; }
+
+    const CodedColumns& cols;
+    StructureOptions options;
+    FamilyScorer scorer;
+    std::unique_ptr<ThreadPool> pool;
+    int m;
+
+    std::vector<std::vector<int>> parents;   // sorted
+    std::vector<char> edge;                  // [u * m + v]
+    std::vector<char> required_edge;
+    std::vector<double> node_score;
+    std::vector<double> delta;
+    std::vector<Move> tabu;                  // inverses of recent moves
+
+    std::vector<std::vector<int>> best_parents;
+    double best_total = 0.0;
+    size_t applied_moves = 0;
+};
+
+#endif // HILL_CLIMB_H
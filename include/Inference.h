@@ -10,6 +10,9 @@
 #include "dataset.h"                // for DataFrame, AttrInfo
 #include "CompensativeParameter.h"  // for CompensativeParameter
 #include "BNStructure.h"            // for BNGraph
+#include "ModelSnapshot.h"          // for ModelSnapshotPtr
+#include "EncodedTable.h"           // for EncodedTable, RowSpan
+#include "ConstraintDetector.h"     // for ConstraintDetector, ViolationBitmap
 
 using std::string;
 using std::vector;
@@ -17,25 +20,35 @@ using std::unordered_map;
 using std::map;
 using std::shared_ptr;
 
-// A single row is an attr→value map
-using Row     = unordered_map<string, string>;
-// A full dataset is a vector of rows
-using DataMap = vector<Row>;
 // Metadata for attributes
 using AttrType = map<string, AttrInfo>;
 
+// What repair_anytime() did to a cell
+enum class CellStatus : uint8_t {
+    Untouched,          // not an error candidate
+    Repaired,           // scored with the full BN + compensative model
+    RepairedDegraded,   // scored BN-only because the deadline was near
+    Skipped             // error candidate left as-is, out of time
+};
+
+// Best repair found within a time budget
+struct AnytimeResult {
+    EncodedTable       data;
+    vector<CellStatus> status;      // num_rows x num_attrs, row-major
+    size_t             full      = 0;
+    size_t             degraded  = 0;
+    size_t             skipped   = 0;
+    bool               completed = false;   // every candidate cell was visited
+};
+
 class Inference {
 public:
-    Inference(const DataMap&                                      dirtyData,
-              const DataMap&                                      processedData,
-              const BNGraph&                                      fullGraph,
-              const unordered_map<string,BNGraph>&                modelDict,
+    // dirtyData and processedData must share one EncodedSchema; the
+    // statistics and graphs are read from model, shared with compParam
+    Inference(const EncodedTable&                                 dirtyData,
+              const EncodedTable&                                 processedData,
+              ModelSnapshotPtr                                    model,
               const AttrType&                                     attrType,
-              const unordered_map<string, unordered_map<string,int>>& frequencyList,
-              const unordered_map<string,
-                    unordered_map<string,
-                        unordered_map<string,
-                            unordered_map<string,int>>>>&         occurrence1,
               const shared_ptr<CompensativeParameter>&            compParam,
               const string&                                       inferStrategy = "PIPD",
               int                                                 chunkSize     = 1,
@@ -43,11 +56,30 @@ public:
               double                                              tuplePrun     = 1.0,
               bool                                                debug         = false);
 
-    // Run repair over all rows
-    DataMap repair(const DataMap&  data,
-                   const DataFrame& cleanData,
-                   const BNGraph&   fullGraph,
-                   const AttrType&  attrType);
+    // Run repair over all rows; values are decoded only by the caller
+    EncodedTable repair(const EncodedTable& data,
+                        const DataFrame&    cleanData,
+                        const BNGraph&      fullGraph,
+                        const AttrType&     attrType);
+
+    // Repair dirty rows [begin, end) only, for callers that stream chunks
+    EncodedTable repair_rows(size_t begin, size_t end);
+
+    // Repair one row encoded against this Inference's schema. Concurrent
+    // calls are safe as long as nobody is encoding new values meanwhile.
+    void repair_row(RowSpan dataLine, ValueCode* repaired, int line = -1);
+
+    // Anytime repair under a wall-clock budget. Cells violating a constraint
+    // are repaired first, then the remaining cells whose co-occurrence support is below
+    // tuplePrun, least supported first. Scoring drops the compensative term
+    // once degradeAt of the budget is spent, or earlier if the projected cost
+    // of the remaining cells would overrun it; cells not reached in time are
+    // left unrepaired and flagged Skipped.
+    AnytimeResult repair_anytime(double budgetSeconds, double degradeAt = 0.5);
+
+    // Approximate heap bytes of the encoded tables and the per-attribute
+    // models; the shared statistics are counted by the ModelSnapshot
+    map<string, size_t> memory_footprint() const;
 
     // // Inference.h
     // std::unordered_map<std::pair<int,std::string>,
@@ -56,29 +88,61 @@ public:
     // const auto& getRepairLog() const { return repairedCells_; }
 
 private:
-    Row repairLine(const Row&                       dataLine,
-                   int                                line,
-                   const BNGraph&                     fullGraph,
-                   const unordered_map<string,BNGraph>& modelDict,
-                   const vector<string>&              nodeList,
-                   const AttrType&                    attrType);
-
-    vector<string> prun(const Row&              dataLine,
-                        int                     line,
-                        const AttrType&         attrType,
-                        const vector<string>&   nodeList);
+    // Per-attribute state precomputed once so that repairLine only indexes
+    // arrays by value code
+    struct AttrModel {
+        int                     id = -1;
+        ValueCode               nullCode = kNoCode;
+        vector<string>          candidates;     // frequencyList_ iteration order
+        vector<ValueCode>       candidateCodes;
+        vector<double>          marginalLog;    // log P(attr = candidate), no parents
+        vector<int>             parentIds;
+        // Per parent: joint count of (candidate index, parent code) and the
+        // parent marginal count indexed by parent code
+        vector<unordered_map<uint64_t, int>> joint;
+        vector<vector<int>>     parentCount;
+        // Single-parent families (e.g. Chow-Liu trees): log P(c | parent)
+        // of the candidates seen with each parent code, grouped by code.
+        // Candidates not listed score log(1e-9).
+        vector<uint32_t>        treeOffset;     // parent code -> range, size+1
+        vector<int>             treeCand;
+        vector<double>          treeLog;
+    };
+
+    void buildAttrModels();
+
+    // Scores the candidates of one cell; returns the index of the best
+    // candidate in attrModels_[id], or -1 if the attribute has none
+    int scoreCell(RowSpan dataLine, int id, int line, bool withCompensative);
+
+    // Average P(other | cell value) over the other attributes of the row
+    double cellSupport(RowSpan dataLine, int id, const vector<int>& nodeList);
+
+    // Reads dataLine, writes the chosen values into repaired
+    void repairLine(RowSpan                            dataLine,
+                    ValueCode*                         repaired,
+                    int                                line,
+                    const BNGraph&                     fullGraph,
+                    const unordered_map<string,BNGraph>& modelDict,
+                    const vector<int>&                 nodeList,
+                    const AttrType&                    attrType);
+
+    // Attributes of the row that violate a constraint: looked up in
+    // violations_ for rows of dirtyData_, checked directly otherwise
+    vector<int> prun(RowSpan                dataLine,
+                     int                    line,
+                     const AttrType&        attrType,
+                     const vector<int>&     nodeList);
 
     // members
-    DataMap                                             dirtyData_;
-    DataMap                                             data_;
-    BNGraph                                             model_;
-    unordered_map<string,BNGraph>                       modelDict_;
+    EncodedTable                                        dirtyData_;
+    EncodedTable                                        data_;
+    ModelSnapshotPtr                                    snapshot_;
+    const BNGraph&                                      model_;        // views into snapshot_
+    const unordered_map<string,BNGraph>&                modelDict_;
     AttrType                                            attrType_;
-    unordered_map<string, unordered_map<string,int>>    frequencyList_;
-    unordered_map<string,
-        unordered_map<string,
-            unordered_map<string,
-                unordered_map<string,int>>>>             occurrence1_;
+    const FrequencyList&                                frequencyList_;
+    const Occurrence1List&                              occurrence1_;
     shared_ptr<CompensativeParameter>                   compParam_;
     string                                              inferStrategy_;
     int                                                 chunkSize_;
@@ -86,6 +150,10 @@ private:
     double                                              tuplePrun_;
     bool                                                debug_;
     unordered_map<string,string>                        repairErr_;
+    vector<AttrModel>                                   attrModels_;   // by attribute id
+    vector<int>                                         nodes_;        // ids of attrType_ attributes
+    ConstraintDetector                                  detector_;
+    ViolationBitmap                                     violations_;   // over dirtyData_
 };
 
 #endif // INFERENCE_H
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef INTERN_POOL_H
+#define INTERN_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Id of a value in an InternPool; equal ids mean equal values
+using InternId = std::uint32_t;
+constexpr InternId kNoIntern = UINT32_MAX;
+
+// Stores every distinct string once and hands out stable ids. The strings
+// live in chunks that never move, each twice the size of the one before,
+// so str() references and view()s stay valid for the life of the pool;
+// values are never removed. Values up to 15 characters (most cells) sit wholly inside the
+// chunks; longer ones keep their characters in one heap buffer each.
+//
+// intern() locks one of kShards shards, picked by hash, so threads
+// interning different values rarely contend; str() and view() take no lock.
+class InternPool {
+public:
+    // The pool every stage shares
+    static InternPool& global();
+
+    InternPool();
+    ~InternPool();
+
+    InternPool(const InternPool&) = delete;
+    InternPool& operator=(const InternPool&) = delete;
+
+    InternId intern(std::string_view value);
+
+    // Id of value, or kNoIntern if it was never interned
+    InternId find(std::string_view value) const;
+
+    const std::string& str(InternId id) const
+    {
+        const size_t local = id / kShards;
+        const int c = chunk_of(local);
+        return shards_[id % kShards].chunks[c].load(std::memory_order_acquire)[local - chunk_start(c)];
+    }
+    std::string_view view(InternId id) const { return str(id); }
+
+    size_t size() const;
+
+    // Approximate heap bytes of the chunks, the long values and the index
+    size_t memory_footprint() const;
+
+private:
+    static const size_t kShards = 16;
+    static const size_t kFirstChunk = 64;   // strings in chunk 0; chunk c holds kFirstChunk << c
+    static const int kChunks = 26;          // enough for every InternId
+
+    static int chunk_of(size_t local) { return 63 - __builtin_clzll(local / kFirstChunk + 1); }
+    static size_t chunk_start(int c) { return kFirstChunk * ((size_t(1) << c) - 1); }
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string_view, InternId> index;   // views into the chunks
+        std::atomic<std::string*> chunks[kChunks];
+        size_t count = 0;
+    };
+
+    std::unique_ptr<Shard[]> shards_;
+};
+
+#endif // INTERN_POOL_H
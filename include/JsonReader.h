@@ -0,0 +1,61 @@
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+// Receives the events of JsonReader::parse in document order. Strings are
+// unescaped; numbers come with their source text.
+class JsonHandler {
+public:
+    virtual ~JsonHandler() = default;
+
+    virtual void start_object() {}
+    virtual void end_object() {}
+    virtual void start_array() {}
+    virtual void end_array() {}
+    virtual void key(const std::string& /*name*/) {}
+    virtual void string_value(const std::string& /*value*/) {}
+    virtual void number(const std::string& /*text*/, double /*value*/) {}
+    virtual void boolean(bool /*value*/) {}
+    virtual void null() {}
+};
+
+// Streaming (SAX-style) JSON tokenizer: reads the input in blocks and
+// reports each token as it is read, without building a document.
+class JsonReader {
+public:
+    explicit JsonReader(std::istream& in);
+
+    // Parses one JSON value; false on a syntax error, see error()
+    bool parse(JsonHandler& handler);
+
+    // What went wrong and where, e.g. "line 3, column 7: expected ':'"
+    const std::string& error() const { return message; }
+
+    static const int kMaxDepth = 512;
+
+private:
+    int peek();
+    int get();
+    void skip_space();
+    bool fail(const std::string& what);
+
+    bool parse_value(JsonHandler& handler, int depth);
+    bool parse_string(std::string& out);
+    bool parse_number(JsonHandler& handler);
+    bool parse_literal(const char* word);
+
+    std::istream& in;
+    std::vector<char> buffer;
+    size_t pos = 0;
+    size_t end = 0;
+    size_t line = 1;
+    size_t column = 1;
+    std::string message;
+    std::string scratch;
+};
+
+#endif // JSON_READER_H
@@ -0,0 +1,90 @@
+#ifndef MEMORY_FOOTPRINT_H
+#define MEMORY_FOOTPRINT_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Approximate heap bytes held by a container and everything it owns, not
+// counting the object itself. Assumes the libstdc++ layouts: strings keep
+// up to 15 characters inline, hash nodes hold a next pointer and the
+// cached hash beside the element, tree nodes three pointers and a color.
+// Allocator rounding is ignored.
+
+template <typename T>
+std::enable_if_t<std::is_trivially_copyable<T>::value, size_t> footprint(const T&) { return 0; }
+inline size_t footprint(const std::string& s);
+template <typename A, typename B> size_t footprint(const std::pair<A, B>& p);
+template <typename T, typename Alloc> size_t footprint(const std::vector<T, Alloc>& v);
+template <typename K, typename V, typename H, typename E, typename Alloc>
+size_t footprint(const std::unordered_map<K, V, H, E, Alloc>& m);
+template <typename K, typename V, typename C, typename Alloc>
+size_t footprint(const std::map<K, V, C, Alloc>& m);
+template <typename K, typename C, typename Alloc>
+size_t footprint(const std::set<K, C, Alloc>& s);
+template <typename T> size_t footprint(const std::shared_ptr<T>& p);
+
+inline size_t footprint(const std::string& s)
+{
+    return s.capacity() > 15 ? s.capacity() + 1 : 0;
+}
+
+template <typename A, typename B>
+size_t footprint(const std::pair<A, B>& p)
+{
+    return footprint(p.first) + footprint(p.second);
+}
+
+template <typename T, typename Alloc>
+size_t footprint(const std::vector<T, Alloc>& v)
+{
+    size_t bytes = v.capacity() * sizeof(T);
+    for (const auto& e : v)
+        bytes += footprint(e);
+    return bytes;
+}
+
+template <typename K, typename V, typename H, typename E, typename Alloc>
+size_t footprint(const std::unordered_map<K, V, H, E, Alloc>& m)
+{
+    const size_t node = sizeof(void*) + sizeof(std::pair<const K, V>) + sizeof(size_t);
+    size_t bytes = m.bucket_count() * sizeof(void*) + m.size() * node;
+    for (const auto& kv : m)
+        bytes += footprint(kv.first) + footprint(kv.second);
+    return bytes;
+}
+
+template <typename K, typename V, typename C, typename Alloc>
+size_t footprint(const std::map<K, V, C, Alloc>& m)
+{
+    const size_t node = 3 * sizeof(void*) + sizeof(int) + sizeof(std::pair<const K, V>);
+    size_t bytes = m.size() * node;
+    for (const auto& kv : m)
+        bytes += footprint(kv.first) + footprint(kv.second);
+    return bytes;
+}
+
+template <typename K, typename C, typename Alloc>
+size_t footprint(const std::set<K, C, Alloc>& s)
+{
+    const size_t node = 3 * sizeof(void*) + sizeof(int) + sizeof(K);
+    size_t bytes = s.size() * node;
+    for (const auto& k : s)
+        bytes += footprint(k);
+    return bytes;
+}
+
+// Counted whole at every owner, so shared objects count more than once
+template <typename T>
+size_t footprint(const std::shared_ptr<T>& p)
+{
+    return p ? sizeof(T) + footprint(*p) : 0;
+}
+
+#endif // MEMORY_FOOTPRINT_H
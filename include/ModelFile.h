@@ -0,0 +1,81 @@
+#ifndef MODEL_FILE_H
+#define MODEL_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "BNStructure.h"  // Edge, BNGraph
+#include "Contingency.h"  // CodedColumns
+
+// Binary model file: attribute names, per-attribute value dictionaries with
+// counts, the edges of the network and, per family, the counts
+// N(parent configuration) and N(value, parent configuration) from which
+// its CPT is read. All integers are little-endian uint32 unless noted.
+//
+//   header      magic "BCLNMDL1", version, num_attrs, num_edges, pad,
+//               uint64 offsets of the sections below, uint64 file size
+//   strings     every name and value, back to back
+//   attrs       per attribute: name offset, name length, first value,
+//               value count, uint64 family offset
+//   values      per value: string offset, length, count
+//   edges       (from, to) attribute ids
+//   families    per attribute: num_parents, parent ids, num_configs, then
+//               per configuration (sorted by parent codes): parent codes,
+//               N_j, nnz, nnz x (value code, N_jk)
+//
+// Value codes index the attribute's dictionary, which is sorted.
+
+// Writes a model learned from cols (coded in attrs order) with the given
+// edges. Returns false if the file cannot be written.
+bool save_model_file(const std::string& path,
+                     const std::vector<std::string>& attrs,
+                     const CodedColumns& cols,
+                     const std::vector<Edge>& edges);
+
+// Read-only view of a model file mapped into memory. Nothing is parsed up
+// front beyond the header, so opening costs the same for any model size.
+class ModelFile {
+public:
+    ModelFile() = default;
+    ~ModelFile();
+
+    ModelFile(const ModelFile&) = delete;
+    ModelFile& operator=(const ModelFile&) = delete;
+
+    // Maps path; returns false (and prints why) if it is not a model file
+    bool open(const std::string& path);
+    void close();
+    bool is_open() const { return base != nullptr; }
+
+    size_t num_attrs() const;
+    std::string_view attr_name(size_t attr) const;
+    int attr_id(std::string_view name) const;   // -1 if absent
+
+    size_t dict_size(size_t attr) const;
+    std::string_view value(size_t attr, uint32_t code) const;
+    uint32_t value_count(size_t attr, uint32_t code) const;
+    uint32_t lookup(size_t attr, std::string_view value) const;  // UINT32_MAX if absent
+
+    std::vector<Edge> edges() const;
+    std::vector<int> parents(size_t attr) const;
+
+    // P(attr = code | parents = parent_codes) from the stored counts, with
+    // parent_codes in parents(attr) order; 0 for unseen configurations
+    double cpt(size_t attr, const std::vector<uint32_t>& parent_codes, uint32_t code) const;
+
+    // The stored network, every attribute present as a node
+    BNGraph graph() const;
+
+private:
+    const uint32_t* u32(uint64_t offset) const;
+    std::string_view str(uint32_t offset, uint32_t length) const;
+
+    const char* base = nullptr;
+    size_t length = 0;
+    int fd = -1;
+};
+
+#endif // MODEL_FILE_H
@@ -0,0 +1,47 @@
+#ifndef MODEL_SNAPSHOT_H
+#define MODEL_SNAPSHOT_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "BNStructure.h"  // For BNGraph, BNResult
+
+class Compensative;
+
+// attr -> value -> count
+using FrequencyList = std::unordered_map<std::string, std::unordered_map<std::string, int>>;
+// attr -> value -> other attr -> other value -> weighted co-occurrence
+using OccurrenceList = std::unordered_map<std::string,
+    std::unordered_map<std::string,
+        std::unordered_map<std::string,
+            std::unordered_map<std::string, double>>>>;
+// attr -> value -> other attr -> other value -> joint count
+using Occurrence1List = std::unordered_map<std::string,
+    std::unordered_map<std::string,
+        std::unordered_map<std::string,
+            std::unordered_map<std::string, int>>>>;
+
+// Everything repair reads from the training rows: the compensative
+// statistics and the learned graphs. Published once after learning and
+// from then on only reachable through ModelSnapshotPtr, so CompensativeParameter,
+// Inference and any number of threads or jobs share one copy without locks.
+struct ModelSnapshot {
+    FrequencyList frequency;
+    OccurrenceList occurrence;
+    Occurrence1List occurrence1;
+    BNGraph full_graph;
+    std::unordered_map<std::string, BNGraph> partition_graphs;
+
+    // Moves the statistics out of stats, which is left empty, and the
+    // graphs out of bn
+    static std::shared_ptr<const ModelSnapshot> publish(Compensative& stats, BNResult bn);
+
+    // Approximate heap bytes of each statistics map and of the graphs
+    std::map<std::string, size_t> memory_footprint() const;
+};
+
+using ModelSnapshotPtr = std::shared_ptr<const ModelSnapshot>;
+
+#endif // MODEL_SNAPSHOT_H
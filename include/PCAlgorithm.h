@@ -0,0 +1,95 @@
+#ifndef PC_ALGORITHM_H
+#define PC_ALGORITHM_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "BNStructure.h"  // StructureOptions
+#include "Contingency.h"  // CodedColumns
+
+class ThreadPool;
+
+// Conditional-independence tests X _||_ Y | Z over dictionary-coded
+// columns, by G^2 or Pearson chi-square. The stratification of the rows
+// by a conditioning set Z is memoized, so every test sharing Z reuses it;
+// test results are memoized too. Safe to call from several threads.
+class CITestEngine {
+public:
+    enum class Statistic { G2, Chi2 };
+
+    CITestEngine(const CodedColumns& cols, Statistic statistic);
+
+    // p-value of the test; z must be sorted
+    double p_value(int x, int y, const std::vector<int>& z);
+
+    // Drops the memoized strata, e.g. once a PC level is done with them
+    void clear_strata();
+
+    size_t tests_run() const { return tests; }
+    size_t cache_hits() const { return hits; }
+
+    // Rows kept across all memoized strata before new ones are no longer
+    // cached
+    static const size_t kMaxCachedRows = size_t(1) << 26;
+
+private:
+    struct Strata {
+        std::vector<uint32_t> id;   // stratum of each row
+        std::vector<int> size;      // rows per stratum
+    };
+
+    std::shared_ptr<const Strata> strata(const std::vector<int>& z);
+    double compute(int x, int y, const Strata& s) const;
+
+    const CodedColumns& cols;
+    Statistic statistic;
+
+    std::mutex mutex;
+    std::map<std::vector<int>, std::shared_ptr<const Strata>> strata_cache;
+    size_t cached_rows = 0;
+    std::map<std::vector<int>, double> results;   // key: x, y, z...
+    size_t tests = 0;
+    size_t hits = 0;
+};
+
+// PC-stable structure learning: the skeleton is thinned level by level
+// (conditioning sets of size 0, 1, ...), with the adjacencies frozen at the
+// start of each level so its tests are independent and run in parallel.
+// Edges are then oriented from v-structures and Meek's rules, and any
+// remaining undirected edge is oriented without closing a cycle.
+class PCAlgorithm {
+public:
+    PCAlgorithm(const CodedColumns& cols, const StructureOptions& options, int num_worker);
+    ~PCAlgorithm();
+
+    // Required edges are never removed and keep their direction. Returns
+    // the DAG as (parent, child) pairs.
+    std::vector<std::pair<int, int>> run(const std::vector<std::pair<int, int>>& required);
+
+    size_t tests_run() const { return engine.tests_run(); }
+    size_t cache_hits() const { return engine.cache_hits(); }
+
+private:
+    void skeleton();
+    void orient();
+    bool reaches(int from, int to) const;
+
+    bool adjacent(int u, int v) const { return adj[size_t(u) * m + v] != 0; }
+    bool directed(int u, int v) const { return dir[size_t(u) * m + v] != 0; }
+    bool undirected(int u, int v) const { return adjacent(u, v) && !directed(u, v) && !directed(v, u); }
+
+    const CodedColumns& cols;
+    StructureOptions options;
+    CITestEngine engine;
+    std::unique_ptr<ThreadPool> pool;
+    int m;
+
+    std::vector<char> adj;        // symmetric skeleton [u * m + v]
+    std::vector<char> dir;        // u -> v oriented
+    std::vector<char> required;   // [u * m + v]
+    std::map<std::pair<int, int>, std::vector<int>> sepset;   // u < v
+};
+
+#endif // PC_ALGORITHM_H
@@ -0,0 +1,50 @@
+#ifndef PATTERN_DISCOVERY_H
+#define PATTERN_DISCOVERY_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct DataFrame;
+struct ColumnProfile;
+
+// Character-class shape of a value, from a single left-to-right scan: each
+// run of ASCII digits becomes 'D' and each run of ASCII letters 'A', both
+// followed by the run length; every other byte is kept as is. E.g.
+// "12.0 oz" -> "D2.D1 A2". Two values with the same shape are matched alike
+// by any pattern that treats all digits and all letters alike, so a
+// pattern only has to be tried on one value per shape.
+std::string value_shape(std::string_view value);
+
+// Shape frequencies of one column
+struct ShapeHistogram {
+    struct Entry {
+        size_t count = 0;
+        std::string representative;   // first value seen with this shape
+    };
+    std::unordered_map<std::string, Entry> shapes;
+    size_t values = 0;                // non-empty values counted
+
+    // Counts a value, trimmed of spaces and tabs; empty values are skipped
+    void add(std::string_view value);
+};
+
+// Picks the pattern for a column from its shapes: the first candidate
+// matching every value, else the candidate matching the largest share of
+// values if that share is at least 0.8, else ".+".
+std::string pattern_from_shapes(const ShapeHistogram& histogram);
+
+// Pattern of every column from its profile (see ColumnProfile.h)
+std::unordered_map<std::string, std::string> discover_patterns(const DataFrame& data,
+                                                               const std::vector<ColumnProfile>& profiles);
+
+// Profiles data and discovers its patterns, the columns spread over
+// num_worker threads. With sample_size > 0, larger tables are profiled on
+// sample_size evenly spaced rows.
+std::unordered_map<std::string, std::string> discover_patterns(const DataFrame& data,
+                                                               int num_worker = 1,
+                                                               size_t sample_size = 0);
+
+#endif // PATTERN_DISCOVERY_H
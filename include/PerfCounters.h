@@ -0,0 +1,47 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstdint>
+#include <string>
+
+// Hardware counters (cycles, instructions, cache and branch misses) of the
+// calling thread, read with perf_event_open. Threads started after the
+// counters are opened are counted too once they exit, which covers the
+// ThreadPools the stages create and join. Counts are scaled up when the
+// kernel multiplexed the counters.
+//
+// Opening fails without Linux perf support, inside most containers, or
+// when /proc/sys/kernel/perf_event_paranoid forbids it; available() is
+// then false, error() says why and start/stop do nothing.
+class PerfCounters {
+public:
+    struct Values {
+        bool valid = false;
+        uint64_t cycles = 0;
+        uint64_t instructions = 0;
+        uint64_t cache_misses = 0;
+        uint64_t branch_misses = 0;
+
+        double ipc() const { return cycles ? double(instructions) / double(cycles) : 0.0; }
+    };
+
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const { return fds[0] >= 0; }
+    const std::string& error() const { return error_; }
+
+    // Zeroes and starts the counters; stop() returns the counts since
+    void start();
+    Values stop();
+
+private:
+    static const int kCounters = 4;
+    int fds[kCounters];
+    std::string error_;
+};
+
+#endif // PERF_COUNTERS_H
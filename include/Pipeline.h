@@ -0,0 +1,58 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include "dataset.h"      // DataFrame, AttrInfo
+#include "BNStructure.h"  // Edge
+
+// Settings for PipelineExecutor; names follow the BayesianClean constructor
+struct PipelineOptions {
+    std::string infer_strategy = "PIPD";
+    double tuple_prun = 1.0;
+    int chunksize = 250;         // rows per chunk in every stage
+    int queue_capacity = 4;      // chunks buffered between two stages
+    std::string model_choice = "appr";
+    std::vector<Edge> fix_edge;
+    std::string model_path;      // load the network instead of learning it
+    StructureOptions structure;  // settings of the 'hc', 'chowliu' and 'pc' learners
+};
+
+// Streaming counterpart of BayesianClean. Stages run on their own threads,
+// connected by bounded queues:
+//
+//   parse -> preprocess -> statistics | freeze model | repair -> write
+//
+// Parsing of chunk i+1 overlaps with preprocessing and counting of chunk i.
+// Structure learning needs every row (or, with structure.sample_size set, a
+// sample drawn as rows stream past), so it runs once the statistics stage
+// has drained; after that, repaired chunks are written while later chunks
+// are still being repaired.
+class PipelineExecutor {
+public:
+    // An empty attr_type keeps every column of the input
+    PipelineExecutor(const std::map<std::string, AttrInfo>& attr_type,
+                     const PipelineOptions& options = PipelineOptions());
+
+    // Cleans the CSV at dirty_path and writes the repaired rows, in input
+    // order, to output_path. Returns the number of rows written.
+    size_t run(const std::string& dirty_path, const std::string& output_path);
+
+    // Busy time of each stage for the last run, excluding queue waits
+    void print_stage_times() const;
+
+private:
+    struct StageTime {
+        std::string name;
+        double seconds = 0.0;
+        size_t chunks = 0;
+    };
+
+    std::map<std::string, AttrInfo> attr_type;
+    PipelineOptions options;
+    std::vector<StageTime> stage_times;
+    double total_seconds = 0.0;
+};
+
+#endif // PIPELINE_H
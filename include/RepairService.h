@@ -0,0 +1,107 @@
+#ifndef REPAIR_SERVICE_H
+#define REPAIR_SERVICE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "dataset.h"      // DataFrame, AttrInfo
+#include "BNStructure.h"  // Edge
+#include "EncodedTable.h"
+#include "ModelSnapshot.h"
+
+class CompensativeParameter;
+class Inference;
+
+struct ServiceOptions {
+    std::string infer_strategy = "PIPD";
+    double tuple_prun = 1.0;
+    std::string model_choice = "appr";
+    std::vector<Edge> fix_edge;
+    std::string model_path;      // load the network instead of learning it
+    StructureOptions structure;  // settings of the 'hc', 'chowliu' and 'pc' learners
+    size_t max_batch = 64;   // requests repaired per batcher wakeup
+};
+
+// Long-lived repair daemon. The model (structure, compensative statistics
+// and per-attribute candidate indexes) is learned once in the constructor
+// and kept in memory; each request is one CSV row in columns() order and
+// is answered with the repaired row.
+//
+// Requests from all callers are queued and a single batcher thread
+// repairs whatever has accumulated, up to max_batch rows per wakeup. The
+// batcher is the only thread that touches the value dictionaries; values
+// first seen in a request are dropped again once its batch is answered,
+// so memory does not grow with traffic.
+class RepairService {
+public:
+    // training holds the dirty rows restricted to attr_type, as produced by
+    // Dataset::get_real_data
+    RepairService(const DataFrame& training,
+                  const std::map<std::string, AttrInfo>& attr_type,
+                  const ServiceOptions& options = ServiceOptions());
+    ~RepairService();
+
+    const std::vector<std::string>& columns() const { return schema->attrs(); }
+
+    // Repairs one CSV row; blocks until its batch is done. Thread-safe.
+    std::string repair(const std::string& line);
+
+    // Answers one line per input line until EOF. The request "?columns"
+    // is answered with the column header.
+    void serve_stream(std::istream& in, std::ostream& out);
+
+    // Accepts connections on a Unix domain socket, one thread per
+    // connection, speaking the same line protocol. Returns false if the
+    // socket cannot be opened, true once stop() has been called.
+    bool serve_unix(const std::string& socket_path);
+
+    // Makes serve_unix() return; safe to call from any thread
+    void stop();
+
+    size_t batches_served() const { return batches; }
+    size_t rows_served() const { return rows; }
+
+private:
+    struct Request {
+        std::string line;
+        std::promise<std::string> reply;
+    };
+
+    std::string answer(const std::string& line);
+    std::vector<std::string> answer_all(const std::vector<std::string>& lines);
+    void batch_loop();
+    void repair_batch(std::vector<Request*>& batch);
+    void handle_connection(int fd);
+
+    std::map<std::string, AttrInfo> attr_type;
+    ServiceOptions options;
+
+    std::shared_ptr<EncodedSchema> schema;
+    ModelSnapshotPtr model;
+    std::shared_ptr<CompensativeParameter> compensativeParameter;
+    std::shared_ptr<Inference> inference;
+
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::deque<Request*> pending;
+    bool stopping = false;
+    std::thread batcher;
+
+    std::mutex conn_mutex;
+    std::vector<int> connection_fds;
+    std::atomic<int> listen_fd{-1};
+    std::atomic<bool> serving{false};
+
+    std::atomic<size_t> batches{0};
+    std::atomic<size_t> rows{0};
+};
+
+#endif // REPAIR_SERVICE_H
@@ -0,0 +1,77 @@
+#ifndef STAGE_REPORT_H
+#define STAGE_REPORT_H
+
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "AllocTracker.h"
+#include "PerfCounters.h"
+
+// Cost of one pipeline stage
+struct StageMetrics {
+    std::string name;
+    size_t rows = 0;                 // rows the stage worked on
+    double wall_seconds = 0.0;
+    double cpu_seconds = 0.0;        // all threads of the process
+    long peak_rss_delta_kb = 0;      // growth of the peak resident set
+    std::map<std::string, size_t> sizes;   // e.g. entries of the maps built
+    PerfCounters::Values counters;         // valid with enable_counters()
+
+    // Heap use while alloc::tracking() (see AllocTracker.h): allocations
+    // and bytes made by the stage, the highest live bytes reached during
+    // it and the live bytes it left behind
+    bool alloc_tracked = false;
+    uint64_t allocs = 0;
+    uint64_t alloc_bytes = 0;
+    int64_t peak_live_bytes = 0;
+    int64_t live_bytes_delta = 0;
+
+    double rows_per_second() const { return wall_seconds > 0 ? rows / wall_seconds : 0.0; }
+};
+
+// Per-stage timing, memory and throughput of one run. Stages are
+// sequential: begin() ends the running stage, if any, and starts the next.
+//
+//   report.begin("preprocess", rows);
+//   ...
+//   report.set_size("frequency_entries", n);
+//   report.end();
+//   report.write_json("stage_report.json");
+class StageReport {
+public:
+    void begin(const std::string& name, size_t rows);
+    void end();
+
+    // Also reads hardware counters around every later stage. Returns false,
+    // and says why on cerr, when they are unavailable; the report is then
+    // written without them.
+    bool enable_counters();
+
+    // Both apply to the running stage, else to the last one; set_rows is
+    // for stages that only learn their row count at the end
+    void set_rows(size_t rows);
+    void set_size(const std::string& key, size_t value);
+
+    const std::vector<StageMetrics>& stages() const { return stages_; }
+
+    void write_json(std::ostream& out) const;
+    bool write_json(const std::string& path) const;
+
+private:
+    std::vector<StageMetrics> stages_;
+    bool running_ = false;
+    std::chrono::steady_clock::time_point wall_start_;
+    double cpu_start_ = 0.0;
+    long rss_start_kb_ = 0;
+    std::unique_ptr<PerfCounters> counters_;
+    alloc::Counters alloc_start_;
+};
+
+// Peak resident set size of the process so far, in KiB
+long peak_rss_kb();
+
+#endif // STAGE_REPORT_H
@@ -0,0 +1,45 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel loops. run(count, fn)
+// calls fn(0) .. fn(count - 1), handing out indices in increasing order as
+// threads become free, and returns once every call has finished. The
+// calling thread takes part, so a pool of size 1 runs inline.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t num_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size() + 1; }
+
+    void run(size_t count, const std::function<void(size_t)>& fn);
+
+private:
+    void worker_loop();
+    void drain();
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(size_t)>* task = nullptr;
+    size_t task_count = 0;
+    std::atomic<size_t> next{0};
+    size_t active = 0;
+    size_t generation = 0;
+    bool stopping = false;
+};
+
+#endif // THREAD_POOL_H
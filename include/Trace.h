@@ -0,0 +1,66 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Scoped trace spans, written as Chrome trace-event JSON for
+// chrome://tracing or ui.perfetto.dev. Spans are compiled in only with
+// -DBCLEAN_TRACE (make TRACE=1); otherwise TRACE_SCOPE expands to nothing.
+//
+//   void Inference::repairLine(...)
+//   {
+//       TRACE_SCOPE("repairLine");
+//       ...
+//   }
+//   ...
+//   trace::write_json("trace.json");
+//
+// Every thread appends to its own buffer, so recording takes no lock; a
+// thread keeps at most kMaxEventsPerThread spans and counts the rest as
+// dropped.
+namespace trace {
+
+const size_t kMaxEventsPerThread = size_t(1) << 20;
+
+// Nanoseconds since the first call in the process
+uint64_t now_ns();
+
+// Records a finished span; name must outlive the process (a literal).
+// arg is shown in the trace when it is not negative.
+void record(const char* name, int64_t arg, uint64_t start_ns, uint64_t end_ns);
+
+// Writes every span recorded so far; threads may keep recording meanwhile
+bool write_json(const std::string& path);
+
+// Spans not recorded because a thread buffer was full
+size_t dropped();
+
+class Span {
+public:
+    explicit Span(const char* name, int64_t arg = -1) : name_(name), arg_(arg), start_(now_ns()) {}
+    ~Span() { record(name_, arg_, start_, now_ns()); }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    const char* name_;
+    int64_t arg_;
+    uint64_t start_;
+};
+
+}  // namespace trace
+
+#ifdef BCLEAN_TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) trace::Span TRACE_CONCAT(trace_span_, __LINE__)(name)
+#define TRACE_SCOPE_ARG(name, arg) trace::Span TRACE_CONCAT(trace_span_, __LINE__)(name, int64_t(arg))
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_SCOPE_ARG(name, arg) ((void)0)
+#endif
+
+#endif // TRACE_H
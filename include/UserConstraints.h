@@ -5,23 +5,31 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <map>
 #include <regex>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 
-// Forward declare DataFrame (it is already defined in dataset.h)
-struct DataFrame;
+#include "dataset.h"  // DataFrame, AttrInfo
+#include "ColumnProfile.h"
 
 // Define the UC (User Constraints) class
 class UC {
 public:
     UC(const DataFrame& data);  // Now takes a reference to DataFrame
 
+    // Constraint fields of one attribute, as given
+    using Fields = std::unordered_map<std::string, std::string>;
+
     // Get all constraints
     std::unordered_map<std::string, std::unordered_map<std::string, std::string>> get_uc();
 
-    // Default setting to find min/max values for an attribute
+    // The same constraints typed, kept in step with get_uc(); attributes
+    // without a type are "Unknown"
+    const std::map<std::string, AttrInfo>& get_attr_info() const;
+
+    // Default min/max for an attribute, from its column profile
     std::string default_setting(const std::string& attr, const std::string& type, const std::string& name);
 
     // Build the user constraints for a specific attribute
@@ -29,23 +37,29 @@ public:
                const std::string& max_v = "", const std::string& null_allow = "N", const std::string& repairable = "Y", 
                const std::string& pattern = "");
 
-    // Build UC from a JSON file
+    // Build UC from a JSON file, read with a streaming tokenizer
     void build_from_json(const std::string& jpath);
 
     // Print the user constraints for an attribute
     void edit(const std::string& df_attr, const std::string& uc_attr, const std::string& uc_v);
 
-    // Discover patterns in each column using regex
-    std::unordered_map<std::string, std::string> PatternDiscovery();
+    // Discover patterns in each column, one pass per column with the columns
+    // spread over num_worker threads; sample_size > 0 profiles larger
+    // columns on that many rows
+    std::unordered_map<std::string, std::string> PatternDiscovery(int num_worker = 1, size_t sample_size = 0);
 
 private:
     const DataFrame& data;  // Now holding a reference to DataFrame
     std::unordered_map<std::string, std::unordered_map<std::string, std::string>> res;
+    std::map<std::string, AttrInfo> info;
+
+    static AttrInfo to_attr_info(const Fields& fields);
 
-    // Helper function to extract values from a specific column
-    std::vector<std::string> get_column_values(const std::string& attr);
+    // Column profiles of data, computed on first use
+    std::vector<ColumnProfile> profiles;
+    const std::vector<ColumnProfile>& profile(int num_worker = 1);
 
-    // Placeholder function to simulate pattern discovery
+    // Pattern of a single column
     std::string discover_pattern_in_column(const std::string& col);
 };
 
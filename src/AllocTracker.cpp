@@ -0,0 +1,81 @@
+#include "../include/AllocTracker.h"
+#include <atomic>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+namespace {
+
+std::atomic<bool> g_tracking{false};
+std::atomic<uint64_t> g_allocs{0};
+std::atomic<uint64_t> g_frees{0};
+std::atomic<uint64_t> g_bytes{0};
+std::atomic<int64_t> g_live{0};
+std::atomic<int64_t> g_peak{0};
+
+void count_alloc(void* p)
+{
+    const int64_t size = int64_t(malloc_usable_size(p));
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(uint64_t(size), std::memory_order_relaxed);
+    const int64_t live = g_live.fetch_add(size, std::memory_order_relaxed) + size;
+    int64_t peak = g_peak.load(std::memory_order_relaxed);
+    while (live > peak && !g_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+void count_free(void* p)
+{
+    g_frees.fetch_add(1, std::memory_order_relaxed);
+    g_live.fetch_sub(int64_t(malloc_usable_size(p)), std::memory_order_relaxed);
+}
+
+}  // namespace
+
+// The array, nothrow and sized forms default to these two
+void* operator new(size_t size)
+{
+    void* p = std::malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    if (g_tracking.load(std::memory_order_relaxed))
+        count_alloc(p);
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    if (p && g_tracking.load(std::memory_order_relaxed))
+        count_free(p);
+    std::free(p);
+}
+
+namespace alloc {
+
+void set_tracking(bool on)
+{
+    g_tracking.store(on, std::memory_order_relaxed);
+}
+
+bool tracking()
+{
+    return g_tracking.load(std::memory_order_relaxed);
+}
+
+Counters snapshot()
+{
+    Counters c;
+    c.allocs = g_allocs.load(std::memory_order_relaxed);
+    c.frees = g_frees.load(std::memory_order_relaxed);
+    c.bytes = g_bytes.load(std::memory_order_relaxed);
+    c.live_bytes = g_live.load(std::memory_order_relaxed);
+    c.peak_live_bytes = g_peak.load(std::memory_order_relaxed);
+    return c;
+}
+
+void reset_peak()
+{
+    g_peak.store(g_live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+}  // namespace alloc
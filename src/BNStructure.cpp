@@ -1,4 +1,10 @@
 #include "../include/BNStructure.h"
+#include "../include/Contingency.h"
+#include "../include/HillClimb.h"
+#include "../include/ModelFile.h"
+#include "../include/PCAlgorithm.h"
+#include "../include/ThreadPool.h"
+#include "../include/Trace.h"
 #include <iostream>
 #include <chrono>
 #include <cmath>
@@ -14,8 +20,11 @@ BNStructure::BNStructure(const DataFrame &data,
                          const string &model_path,
                          const string &model_choice,
                          const std::vector<Edge> &fix_edge,
-                         const string &model_save_path)
-    : data(data), model_path(model_path), model_choice(model_choice), fix_edge(fix_edge), model_save_path(model_save_path) {}
+                         const string &model_save_path,
+                         int num_worker,
+                         const StructureOptions &options)
+    : data(data), model_path(model_path), model_choice(model_choice), model_save_path(model_save_path), fix_edge(fix_edge),
+      num_worker(num_worker > 0 ? num_worker : 1), options(options) {}
 
 void BNStructure::print_bn_result(const BNResult &result)
 {
@@ -47,12 +56,7 @@ void BNStructure::print_graph(const BNGraph &graph)
 
 BNResult BNStructure::get_bn()
 {
-    vector<string> attributes;
-    if (!data.rows.empty())
-    {
-        for (size_t i = 0; i < data.rows[0].size(); ++i)
-            attributes.push_back("Attr" + to_string(i));
-    }
+    vector<string> attributes = attribute_names(data);
 
     for (const auto &attr : attributes)
     {
@@ -62,16 +66,63 @@ BNResult BNStructure::get_bn()
     BNGraph G;
     unordered_map<string, BNGraph> model_dict;
 
+    // Large tables are learned from a sample; get_rel re-checks borderline
+    // MI estimates on the larger nested sample
+    const DataFrame *learn = &data;
+    DataFrame sample;
+    if (options.sample_size > 0 && data.rows.size() > options.sample_size)
+    {
+        size_t recheck_size = options.recheck_sample_size > 0 ? options.recheck_sample_size
+                                                              : 4 * options.sample_size;
+        int stratify = -1;
+        if (!options.sample_stratify.empty())
+        {
+            auto it = find(data.columns.begin(), data.columns.end(), options.sample_stratify);
+            if (it != data.columns.end())
+                stratify = it - data.columns.begin();
+            else
+                cout << "Unknown stratification column " << options.sample_stratify << endl;
+        }
+        RowSampler sampler(options.sample_size, recheck_size, stratify, options.seed);
+        for (const auto &row : data.rows)
+            sampler.add(row);
+        sample = sampler.sample(data.columns);
+        recheck_data = sampler.recheck(data.columns);
+        learn = &sample;
+        cout << "Structure learning on a sample of " << sample.rows.size() << " of "
+             << data.rows.size() << " rows" << endl;
+    }
+
+    bool loaded = false;
     if (!model_path.empty())
     {
-        cout << "Model loading from file is not implemented in this C++ version." << endl;
+        auto start = chrono::high_resolution_clock::now();
+        ModelFile file;
+        if (file.open(model_path))
+        {
+            G = file.graph();
+            loaded = true;
+            for (const auto &attr : attributes)
+                if (!G.adjacency_list.count(attr))
+                    cout << "Attribute " << attr << " is not in the model file" << endl;
+
+            auto end = chrono::high_resolution_clock::now();
+            chrono::duration<double> diff = end - start;
+            cout << "Model loaded from " << model_path << " (" << file.num_attrs() << " attributes, "
+                 << file.edges().size() << " edges) in " << diff.count() << " seconds" << endl;
+        }
+        else
+        {
+            cout << "Falling back to structure learning" << endl;
+        }
     }
-    else
+
+    if (!loaded)
     {
         if (model_choice == "appr")
         {
             auto start = chrono::high_resolution_clock::now();
-            vector<Edge> Edges = get_rel(data);
+            vector<Edge> Edges = get_rel(*learn);
 
             for (const auto &attr : attributes)
                 G.adjacency_list[attr] = set<string>();
@@ -82,6 +133,48 @@ BNResult BNStructure::get_bn()
             chrono::duration<double> diff = end - start;
             cout << "Approximate structure time used: " << diff.count() << " seconds" << endl;
         }
+        else if (model_choice == "hc")
+        {
+            auto start = chrono::high_resolution_clock::now();
+            vector<Edge> Edges = get_hill_climb(*learn, attributes);
+
+            for (const auto &attr : attributes)
+                G.adjacency_list[attr] = set<string>();
+            for (const auto &edge : Edges)
+                G.adjacency_list[edge.from].insert(edge.to);
+
+            auto end = chrono::high_resolution_clock::now();
+            chrono::duration<double> diff = end - start;
+            cout << "Hill climbing structure time used: " << diff.count() << " seconds" << endl;
+        }
+        else if (model_choice == "chowliu")
+        {
+            auto start = chrono::high_resolution_clock::now();
+            vector<Edge> Edges = get_chow_liu(*learn, attributes);
+
+            for (const auto &attr : attributes)
+                G.adjacency_list[attr] = set<string>();
+            for (const auto &edge : Edges)
+                G.adjacency_list[edge.from].insert(edge.to);
+
+            auto end = chrono::high_resolution_clock::now();
+            chrono::duration<double> diff = end - start;
+            cout << "Chow-Liu structure time used: " << diff.count() << " seconds" << endl;
+        }
+        else if (model_choice == "pc")
+        {
+            auto start = chrono::high_resolution_clock::now();
+            vector<Edge> Edges = get_pc(*learn, attributes);
+
+            for (const auto &attr : attributes)
+                G.adjacency_list[attr] = set<string>();
+            for (const auto &edge : Edges)
+                G.adjacency_list[edge.from].insert(edge.to);
+
+            auto end = chrono::high_resolution_clock::now();
+            chrono::duration<double> diff = end - start;
+            cout << "PC structure time used: " << diff.count() << " seconds" << endl;
+        }
         else if (model_choice == "fix")
         {
             for (const auto &attr : attributes)
@@ -91,10 +184,20 @@ BNResult BNStructure::get_bn()
         }
         else
         {
-            cout << "Only 'appr' and 'fix' modes are implemented in this C++ version." << endl;
+            cout << "Only 'appr', 'hc', 'chowliu', 'pc' and 'fix' modes are implemented in this C++ version." << endl;
         }
     }
 
+    if (!loaded && !model_save_path.empty())
+    {
+        vector<Edge> edges;
+        for (const auto &p : G.adjacency_list)
+            for (const auto &c : p.second)
+                edges.emplace_back(p.first, c);
+        if (save_model_file(model_save_path, attributes, CodedColumns::encode(data), edges))
+            cout << "Model saved to " << model_save_path << endl;
+    }
+
     for (const auto &node : G.adjacency_list)
     {
         const string &key = node.first;
@@ -143,50 +246,75 @@ BNResult BNStructure::get_bn()
 
 vector<Edge> BNStructure::get_rel(const DataFrame &data)
 {
-    vector<string> attrs;
-    if (!data.rows.empty())
-    {
-        for (size_t i = 0; i < data.rows[0].size(); ++i)
-            attrs.push_back("Attr" + to_string(i));
-    }
+    vector<string> attrs = attribute_names(data);
 
-    int n = data.rows.size();
     int m = attrs.size();
     int max_indegree = 2;
 
     map<pair<string, string>, double> mi_map;
 
-    for (int i = 0; i < m; ++i)
+    const double threshold = 0.01;
+    CodedColumns cols = CodedColumns::encode(data);
+    vector<double> variance;
+    vector<double> mi = pairwise_mi(cols, &variance);
+
+    // On a sample, pairs whose 95% interval straddles the threshold are
+    // estimated again on the larger recheck sample
+    intervals.clear();
+    if (recheck_data.rows.size() > data.rows.size())
     {
-        for (int j = 0; j < m; ++j)
+        vector<pair<int, int>> borderline;
+        vector<size_t> borderline_interval;
+        for (int i = 0; i < m; ++i)
         {
-            if (i == j)
-                continue;
-
-            map<string, int> count_i, count_j;
-            map<pair<string, string>, int> count_ij;
-
-            for (int k = 0; k < n; ++k)
+            for (int j = i + 1; j < m; ++j)
             {
-                string vi = data.rows[k][i];
-                string vj = data.rows[k][j];
-                count_i[vi]++;
-                count_j[vj]++;
-                count_ij[{vi, vj}]++;
+                double half = 1.96 * sqrt(variance[i * m + j]);
+                double est = mi[i * m + j];
+                intervals.push_back({attrs[i], attrs[j], est, est - half, est + half, false});
+                if (est - half <= threshold && threshold <= est + half)
+                {
+                    borderline.emplace_back(i, j);
+                    borderline_interval.push_back(intervals.size() - 1);
+                }
             }
+        }
 
-            double mi = 0.0;
-            for (const auto &p : count_ij)
+        if (!borderline.empty())
+        {
+            CodedColumns wide = CodedColumns::encode(recheck_data);
+            vector<MIEstimate> again(borderline.size());
+            ThreadPool pool(min<size_t>(num_worker, borderline.size()));
+            pool.run(borderline.size(), [&](size_t k)
+                     {
+                         int i = borderline[k].first, j = borderline[k].second;
+                         TRACE_SCOPE_ARG("mutual_information_recheck", i * m + j);
+                         again[k] = mutual_information_estimate(wide, i, j);
+                     });
+
+            for (size_t k = 0; k < borderline.size(); ++k)
             {
-                string vi = p.first.first;
-                string vj = p.first.second;
-                double p_ij = (double)p.second / n;
-                double p_i = (double)count_i[vi] / n;
-                double p_j = (double)count_j[vj] / n;
-                mi += p_ij * log((p_ij / (p_i * p_j)) + 1e-9);
+                int i = borderline[k].first, j = borderline[k].second;
+                mi[i * m + j] = mi[j * m + i] = again[k].mi;
+                double half = 1.96 * sqrt(again[k].variance);
+                intervals[borderline_interval[k]] = {attrs[i], attrs[j], again[k].mi,
+                                                     again[k].mi - half, again[k].mi + half, true};
             }
+        }
+
+        cout << "MI estimated on " << data.rows.size() << " sampled rows; " << borderline.size()
+             << " borderline pairs re-checked on " << recheck_data.rows.size() << " rows" << endl;
+        for (const auto &iv : intervals)
+            cout << "  MI(" << iv.a << ", " << iv.b << ") = " << iv.mi << " [" << iv.low << ", "
+                 << iv.high << "]" << (iv.rechecked ? " rechecked" : "") << endl;
+    }
 
-            mi_map[{attrs[i], attrs[j]}] = mi;
+    for (int i = 0; i < m; ++i)
+    {
+        for (int j = i + 1; j < m; ++j)
+        {
+            mi_map[{attrs[i], attrs[j]}] = mi[i * m + j];
+            mi_map[{attrs[j], attrs[i]}] = mi[i * m + j];
         }
     }
 
@@ -198,7 +326,7 @@ vector<Edge> BNStructure::get_rel(const DataFrame &data)
         string to = entry.first.second;
         double mi = entry.second;
 
-        if (mi > 0.01)
+        if (mi > threshold)
         {
             candidate_parents[to].emplace_back(from, mi);
         }
@@ -242,4 +370,210 @@ vector<Edge> BNStructure::get_rel(const DataFrame &data)
     cout << "]" << endl;
 
     return final_edges;
-}
\ No newline at end of file
+}
+
+vector<Edge> BNStructure::get_hill_climb(const DataFrame &data, const vector<string> &attrs)
+{
+    CodedColumns cols = CodedColumns::encode(data);
+    HillClimbSearch search(cols, options, num_worker);
+    vector<pair<int, int>> found = search.run(fixed_edge_ids(attrs));
+
+    cout << "Hill climbing (" << options.score << "): " << search.moves() << " moves, score "
+         << search.best_score() << ", " << search.cached_families() << " families scored" << endl;
+
+    vector<Edge> edges;
+    for (const auto &e : found)
+        edges.emplace_back(attrs[e.first], attrs[e.second]);
+    return edges;
+}
+
+vector<double> BNStructure::pairwise_mi(const CodedColumns &cols, vector<double> *variance)
+{
+    const size_t m = cols.num_attrs();
+
+    // MI is symmetric, so each unordered pair is counted once. Pairs are
+    // handed out largest contingency table first so the most expensive
+    // ones do not end up trailing on a single thread
+    vector<pair<int, int>> pairs;
+    for (size_t i = 0; i < m; ++i)
+        for (size_t j = i + 1; j < m; ++j)
+            pairs.emplace_back(i, j);
+    stable_sort(pairs.begin(), pairs.end(),
+                [&](const pair<int, int> &a, const pair<int, int> &b)
+                {
+                    return cols.cardinality(a.first) * cols.cardinality(a.second) >
+                           cols.cardinality(b.first) * cols.cardinality(b.second);
+                });
+
+    // Each pair writes only its own cells, so the result does not depend
+    // on thread timing
+    vector<double> mi(m * m, 0.0);
+    if (variance)
+        variance->assign(m * m, 0.0);
+    ThreadPool pool(min<size_t>(num_worker, max<size_t>(pairs.size(), 1)));
+    pool.run(pairs.size(), [&](size_t k)
+             {
+                 size_t i = pairs[k].first, j = pairs[k].second;
+                 TRACE_SCOPE_ARG("mutual_information", i * m + j);
+                 MIEstimate est = mutual_information_estimate(cols, i, j);
+                 mi[i * m + j] = mi[j * m + i] = est.mi;
+                 if (variance)
+                     (*variance)[i * m + j] = (*variance)[j * m + i] = est.variance;
+             });
+    return mi;
+}
+
+vector<Edge> BNStructure::get_chow_liu(const DataFrame &data, const vector<string> &attrs)
+{
+    const int m = attrs.size();
+    if (m < 2)
+        return {};
+
+    CodedColumns cols = CodedColumns::encode(data);
+    vector<double> mi = pairwise_mi(cols);
+
+    // Fixed edges are forced into the tree by outweighing any MI
+    vector<double> weight = mi;
+    vector<pair<int, int>> forced = fixed_edge_ids(attrs);
+    for (const auto &f : forced)
+        weight[f.first * m + f.second] = weight[f.second * m + f.first] = mi[f.first * m + f.second] + 1e6;
+
+    // Prim's maximum spanning tree on the dense MI matrix, O(m^2)
+    vector<char> in_tree(m, 0);
+    vector<double> best(m, -INFINITY);
+    vector<int> link(m, -1);
+    vector<vector<int>> neighbours(m);
+    best[0] = 0.0;
+    for (int step = 0; step < m; ++step)
+    {
+        int x = -1;
+        for (int v = 0; v < m; ++v)
+            if (!in_tree[v] && (x < 0 || best[v] > best[x]))
+                x = v;
+        in_tree[x] = 1;
+        if (link[x] >= 0)
+        {
+            neighbours[x].push_back(link[x]);
+            neighbours[link[x]].push_back(x);
+        }
+        for (int v = 0; v < m; ++v)
+        {
+            if (!in_tree[v] && weight[x * m + v] > best[v])
+            {
+                best[v] = weight[x * m + v];
+                link[v] = x;
+            }
+        }
+    }
+
+    // Root: the configured attribute, or the one sharing the most MI with
+    // its tree neighbours
+    int root = -1;
+    if (!options.root.empty())
+    {
+        auto it = find(attrs.begin(), attrs.end(), options.root);
+        if (it != attrs.end())
+            root = it - attrs.begin();
+        else
+            cout << "Unknown Chow-Liu root " << options.root << ", picking one" << endl;
+    }
+    if (root < 0)
+    {
+        double best_degree = -1.0;
+        for (int v = 0; v < m; ++v)
+        {
+            double degree = 0.0;
+            for (int u : neighbours[v])
+                degree += mi[v * m + u];
+            if (degree > best_degree)
+            {
+                best_degree = degree;
+                root = v;
+            }
+        }
+    }
+
+    // Orient away from the root. Any orientation of a tree is acyclic, so
+    // fixed edges can then simply keep their own direction
+    vector<int> parent(m, -1);
+    vector<int> order{root};
+    vector<char> seen(m, 0);
+    seen[root] = 1;
+    for (size_t k = 0; k < order.size(); ++k)
+        for (int v : neighbours[order[k]])
+            if (!seen[v])
+            {
+                seen[v] = 1;
+                parent[v] = order[k];
+                order.push_back(v);
+            }
+
+    set<pair<int, int>> tree;
+    for (int v = 0; v < m; ++v)
+        if (parent[v] >= 0)
+            tree.insert({parent[v], v});
+    for (const auto &f : forced)
+    {
+        if (tree.count(f))
+            continue;
+        if (tree.erase({f.second, f.first}))
+            tree.insert(f);
+        else
+            cout << "Fixed edge (" << attrs[f.first] << ", " << attrs[f.second]
+                 << ") would close a cycle in the tree; dropped" << endl;
+    }
+
+    cout << "Chow-Liu tree rooted at " << attrs[root] << endl;
+
+    vector<Edge> edges;
+    for (const auto &e : tree)
+        edges.emplace_back(attrs[e.first], attrs[e.second]);
+    return edges;
+}
+
+vector<Edge> BNStructure::get_pc(const DataFrame &data, const vector<string> &attrs)
+{
+    CodedColumns cols = CodedColumns::encode(data);
+    PCAlgorithm pc(cols, options, num_worker);
+    vector<pair<int, int>> found = pc.run(fixed_edge_ids(attrs));
+
+    cout << "PC (" << options.ci_test << ", alpha " << options.alpha << "): " << pc.tests_run()
+         << " CI tests, " << pc.cache_hits() << " answered from cache" << endl;
+
+    vector<Edge> edges;
+    for (const auto &e : found)
+        edges.emplace_back(attrs[e.first], attrs[e.second]);
+    return edges;
+}
+
+vector<pair<int, int>> BNStructure::fixed_edge_ids(const vector<string> &attrs)
+{
+    vector<pair<int, int>> ids;
+    for (const auto &e : fix_edge)
+    {
+        auto from = find(attrs.begin(), attrs.end(), e.from);
+        auto to = find(attrs.begin(), attrs.end(), e.to);
+        if (from == attrs.end() || to == attrs.end() || from == to)
+        {
+            cout << "Ignoring fixed edge: (" << e.from << ", " << e.to << ")" << endl;
+            continue;
+        }
+        ids.emplace_back(int(from - attrs.begin()), int(to - attrs.begin()));
+    }
+    return ids;
+}
+
+vector<string> BNStructure::attribute_names(const DataFrame &data)
+{
+    // Real column names when they describe the rows; synthetic ones for
+    // bare row sets
+    if (!data.rows.empty() && data.columns.size() == data.rows[0].size())
+        return data.columns;
+    vector<string> names;
+    if (!data.rows.empty())
+    {
+        for (size_t i = 0; i < data.rows[0].size(); ++i)
+            names.push_back("Attr" + to_string(i));
+    }
+    return names;
+}
@@ -1,16 +1,45 @@
 #include "../include/BayesianNetwork.h"
+#include <cmath>
 
 // Adds or updates the probability for the specified attribute and value.
 void BayesianNetwork::addProbability(const std::string& attribute, const std::string& value, double probability) {
-    probabilityTable[attribute][value] = probability;
+    auto a = attributeIds.emplace(attribute, int(tables.size()));
+    if (a.second)
+        tables.emplace_back();
+    Table& t = tables[a.first->second];
+
+    auto v = t.ids.emplace(value, int(t.prob.size()));
+    if (v.second) {
+        t.prob.push_back(probability);
+        t.logProb.push_back(std::log(probability));
+    } else {
+        t.prob[v.first->second] = probability;
+        t.logProb[v.first->second] = std::log(probability);
+    }
 }
 
 // Retrieves the probability for the specified attribute and value.
 // Returns a small default probability (1e-9) if the attribute or value is not found.
-double BayesianNetwork::getProbability(const std::string& attribute, const std::string& value) {
-    if (probabilityTable.find(attribute) != probabilityTable.end() &&
-        probabilityTable[attribute].find(value) != probabilityTable[attribute].end()) {
-        return probabilityTable[attribute][value];
-    }
-    return 1e-9; // Return a very small probability for unseen values
-}
\ No newline at end of file
+double BayesianNetwork::getProbability(const std::string& attribute, const std::string& value) const {
+    int a = attributeId(attribute);
+    int v = a < 0 ? -1 : valueId(a, value);
+    return v < 0 ? kUnseenProbability : tables[a].prob[v];
+}
+
+int BayesianNetwork::attributeId(const std::string& attribute) const {
+    auto it = attributeIds.find(attribute);
+    return it == attributeIds.end() ? -1 : it->second;
+}
+
+int BayesianNetwork::valueId(int attribute, const std::string& value) const {
+    if (attribute < 0)
+        return -1;
+    const auto& ids = tables[attribute].ids;
+    auto it = ids.find(value);
+    return it == ids.end() ? -1 : it->second;
+}
+
+double BayesianNetwork::logProbability(int attribute, int value) const {
+    static const double unseen = std::log(kUnseenProbability);
+    return (attribute < 0 || value < 0) ? unseen : tables[attribute].logProb[value];
+}
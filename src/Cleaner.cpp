@@ -1,4 +1,5 @@
 #include "../include/Cleaner.h"
+#include "../include/ThreadPool.h"
 #include <cmath>
 #include <iostream>
 #include <algorithm>
@@ -21,31 +22,50 @@ void Cleaner::setDomain(const std::string& attribute, const std::vector<std::str
 // The cleanData method applies a simple repair logic:
 // For each cell, it checks the candidate domain and picks the candidate with the highest log-probability
 // (as obtained from the Bayesian network). If the current value is the best, it remains unchanged.
-DataFrameCleaner Cleaner::cleanData() {
-    int n = data.size();
-    int m = attributes.size();
+//
+// Scores depend only on the value, so per attribute the first candidate of
+// highest score is found once; a cell takes it iff it scores strictly
+// higher than the cell's current value, as a scan of the domain would.
+DataFrameCleaner Cleaner::cleanData(int num_worker) {
+    const size_t n = data.size();
+    const size_t m = attributes.size();
     DataFrameCleaner cleanedData = data;  // Start with the original data
 
-    // Iterate over each row and column.
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < m; j++) {
-            std::string attr = attributes[j];
-            std::string currentValue = data[i][j];
-            // Get the probability of the current value from the Bayesian network.
-            double bestScore = std::log(bn.getProbability(attr, currentValue));
-            std::string bestCandidate = currentValue;
-
-            // For each candidate in the domain, compute its log probability.
-            for (const std::string& candidate : domain[attr]) {
-                double score = std::log(bn.getProbability(attr, candidate));
-                if (score > bestScore) {
-                    bestScore = score;
-                    bestCandidate = candidate;
-                }
+    struct Best {
+        int attr = -1;              // interned attribute id, -1 if unknown
+        const std::string* value = nullptr;
+        double score = 0.0;
+    };
+    std::vector<Best> best(m);
+    for (size_t j = 0; j < m; ++j) {
+        Best& b = best[j];
+        b.attr = bn.attributeId(attributes[j]);
+        for (const std::string& candidate : domain[attributes[j]]) {
+            double score = bn.logProbability(b.attr, bn.valueId(b.attr, candidate));
+            if (std::isnan(score))
+                continue;
+            if (!b.value || score > b.score) {
+                b.score = score;
+                b.value = &candidate;
             }
-            // Replace the cell value with the candidate that has the highest score.
-            cleanedData[i][j] = bestCandidate;
         }
     }
+
+    // Rows in blocks, each patched column by column
+    const size_t block = 4096;
+    ThreadPool pool(num_worker > 0 ? num_worker : 1);
+    pool.run((n + block - 1) / block, [&](size_t k) {
+        const size_t end = std::min(n, (k + 1) * block);
+        for (size_t j = 0; j < m; ++j) {
+            const Best& b = best[j];
+            if (!b.value)
+                continue;
+            for (size_t i = k * block; i < end; ++i) {
+                double current = bn.logProbability(b.attr, bn.valueId(b.attr, data[i][j]));
+                if (b.score > current)
+                    cleanedData[i][j] = *b.value;
+            }
+        }
+    });
     return cleanedData;
-}
\ No newline at end of file
+}
@@ -0,0 +1,163 @@
+#include "../include/ColumnProfile.h"
+#include "../include/ThreadPool.h"
+#include "../dataset.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <unordered_map>
+
+//------------------------------- HyperLogLog ---------------------------------
+
+// splitmix64 finalizer, so that every bit of the hash is well mixed
+static uint64_t mix64(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+void HyperLogLog::add(const std::string& value)
+{
+    const uint64_t h = mix64(std::hash<std::string>()(value));
+    const size_t index = size_t(h >> (64 - kPrecision));
+    const uint64_t rest = h << kPrecision;
+    const uint8_t rank = rest ? uint8_t(__builtin_clzll(rest) + 1) : uint8_t(64 - kPrecision + 1);
+    if (rank > registers[index])
+        registers[index] = rank;
+}
+
+void HyperLogLog::merge(const HyperLogLog& other)
+{
+    for (size_t k = 0; k < registers.size(); ++k)
+        registers[k] = std::max(registers[k], other.registers[k]);
+}
+
+double HyperLogLog::estimate() const
+{
+    const double m = double(registers.size());
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (uint8_t r : registers) {
+        sum += std::ldexp(1.0, -int(r));
+        zeros += r == 0;
+    }
+    const double alpha = 0.7213 / (1.0 + 1.079 / m);
+    const double raw = alpha * m * m / sum;
+    // Linear counting is more accurate while many registers are empty
+    if (raw <= 2.5 * m && zeros > 0)
+        return m * std::log(m / double(zeros));
+    return raw;
+}
+
+//------------------------------ profile_columns ------------------------------
+
+namespace {
+
+// Space-Saving heavy hitters with a fixed number of counters
+class HeavyHitters {
+public:
+    explicit HeavyHitters(size_t capacity) : capacity(std::max<size_t>(capacity, 1)) {}
+
+    void add(const std::string& value)
+    {
+        auto it = counters.find(value);
+        if (it != counters.end()) {
+            it->second++;
+            return;
+        }
+        if (counters.size() < capacity) {
+            counters.emplace(value, 1);
+            return;
+        }
+        // Evict the smallest counter; the newcomer inherits its count
+        auto low = counters.begin();
+        for (auto c = counters.begin(); c != counters.end(); ++c)
+            if (c->second < low->second || (c->second == low->second && c->first < low->first))
+                low = c;
+        size_t count = low->second + 1;
+        counters.erase(low);
+        counters.emplace(value, count);
+    }
+
+    std::vector<std::pair<std::string, size_t>> top(size_t k) const
+    {
+        std::vector<std::pair<std::string, size_t>> out(counters.begin(), counters.end());
+        std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) {
+            return a.second != b.second ? a.second > b.second : a.first < b.first;
+        });
+        if (out.size() > k)
+            out.resize(k);
+        return out;
+    }
+
+private:
+    size_t capacity;
+    std::unordered_map<std::string, size_t> counters;
+};
+
+void profile_value(ColumnProfile& p, HeavyHitters& hitters, const std::string& v)
+{
+    p.values++;
+    if (v.empty() || v == "A Null Cell") {
+        p.nulls++;
+        return;
+    }
+
+    const char* begin = v.c_str();
+    char* end = nullptr;
+    double number = std::strtod(begin, &end);
+    if (end != begin) {
+        if (p.numeric == 0 || number < p.min_number) {
+            p.min_number = number;
+            p.min_number_text.assign(begin, size_t(end - begin));
+        }
+        if (p.numeric == 0 || number > p.max_number) {
+            p.max_number = number;
+            p.max_number_text.assign(begin, size_t(end - begin));
+        }
+        p.numeric++;
+    }
+
+    const bool first = p.non_null() == 1;
+    if (first || v.size() < p.min_length) {
+        p.min_length = v.size();
+        p.shortest = v;
+    }
+    if (first || v.size() > p.max_length) {
+        p.max_length = v.size();
+        p.longest = v;
+    }
+
+    p.distinct.add(v);
+    hitters.add(v);
+    p.shapes.add(v);
+}
+
+}  // namespace
+
+std::vector<ColumnProfile> profile_columns(const DataFrame& data,
+                                           int num_worker,
+                                           size_t sample_size,
+                                           size_t top_k)
+{
+    const size_t n = data.rows.size();
+    const size_t take = (sample_size > 0 && sample_size < n) ? sample_size : n;
+
+    std::vector<ColumnProfile> profiles(data.columns.size());
+    ThreadPool pool(num_worker > 0 ? num_worker : 1);
+    pool.run(profiles.size(), [&](size_t col) {
+        ColumnProfile& p = profiles[col];
+        HeavyHitters hitters(4 * top_k);
+        for (size_t k = 0; k < take; ++k) {
+            // Evenly spaced rows, so a sample still spans the whole table
+            const auto& row = data.rows[take == n ? k : k * n / take];
+            if (col < row.size())
+                profile_value(p, hitters, row[col]);
+        }
+        p.top = hitters.top(top_k);
+    });
+    return profiles;
+}
@@ -1,8 +1,12 @@
 #include "Compensative.h"
+#include "MemoryFootprint.h"
+#include "ModelSnapshot.h"
+#include "Trace.h"
 #include <iostream>
 #include <regex>
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
 
 static inline std::string canonical(std::string s) {
     std::string out;
@@ -15,80 +19,152 @@ static inline std::string canonical(std::string s) {
 Compensative::Compensative(const DataFrame& dataFrame, const AttrType& attrs_type)
     : attrs_type(attrs_type)
 {
-    // Convert the DataFrame to our internal Data (vector<Row>)
-    for (const auto &rowVec : dataFrame.rows) {
-        Row row;
-        for (size_t i = 0; i < dataFrame.columns.size() && i < rowVec.size(); ++i) {
-            row[dataFrame.columns[i]] = rowVec[i];
-        }
-        data.push_back(row);
+    // Keeping the order of the former per-row maps keeps the insertion,
+    // and so the iteration, order of the statistics unchanged
+    Row probe;
+    for (const auto& col : dataFrame.columns)
+        probe[col];
+    for (const auto& kv : probe)
+        attrs.push_back(kv.first);
+    append(dataFrame);
+}
+
+vector<size_t> Compensative::source_of(const vector<string>& columns) const {
+    vector<size_t> source(attrs.size(), SIZE_MAX);
+    for (size_t a = 0; a < attrs.size(); ++a) {
+        auto it = std::find(columns.begin(), columns.end(), attrs[a]);
+        if (it != columns.end())
+            source[a] = size_t(it - columns.begin());
     }
+    return source;
+}
+
+void Compensative::append_row(const vector<string>& rowVec, const vector<size_t>& source, InternId empty) {
+    InternPool& pool = InternPool::global();
+    vector<InternId> row(attrs.size(), empty);
+    for (size_t a = 0; a < attrs.size(); ++a)
+        if (source[a] < rowVec.size())
+            row[a] = pool.intern(rowVec[source[a]]);
+    data.push_back(std::move(row));
+}
+
+// Interns rows whose columns are those given to the constructor
+void Compensative::append(const DataFrame& rows) {
+    const vector<size_t> source = source_of(rows.columns);
+    const InternId empty = InternPool::global().intern("");
+    data.reserve(data.size() + rows.rows.size());
+    for (const auto& rowVec : rows.rows)
+        append_row(rowVec, source, empty);
 }
 
 void Compensative::build() {
     occur_and_fre();
 }
 
+void Compensative::add_rows(const DataFrame& chunk) {
+    size_t first = data.size();
+    append(chunk);
+    count_rows(first);
+}
+
+void Compensative::add_rows(CandidateCursor& rows) {
+    size_t first = data.size();
+    const vector<size_t> source = source_of(rows.columns());
+    const InternId empty = InternPool::global().intern("");
+    while (rows.next())
+        append_row(rows.row(), source, empty);
+    count_rows(first);
+}
+
 void Compensative::occur_and_fre() {
     Frequency_list.clear();
     Occurrence_list.clear();
     Occurrence_1.clear();
+    count_rows(0);
+}
+
+// Counts rows [first, data.size()) into the statistics
+void Compensative::count_rows(size_t first) {
+    const InternPool& pool = InternPool::global();
 
     // Frequency counting: count occurrences of each attribute value
-    for (const auto& row : data) {
-        for (const auto& [attr, val] : row) {
-            Frequency_list[attr][val]++;
+    for (size_t i = first; i < data.size(); ++i) {
+        for (size_t a = 0; a < attrs.size(); ++a) {
+            Frequency_list[attrs[a]][pool.str(data[i][a])]++;
         }
     }
 
-    // Compute co-occurrence for each row and attribute
-    for (size_t i = 0; i < data.size(); ++i) {
-        for (const auto& [attr_main, _] : data[i]) {
-            correlate(i, attr_main);
+    // Compute co-occurrence for each row and attribute, in batches of
+    // rows so that traces show their progress
+    const size_t batch = 1024;
+    vector<char> valid(attrs.size());
+    for (size_t b = first; b < data.size(); b += batch) {
+        TRACE_SCOPE_ARG("correlate", b);
+        for (size_t i = b; i < data.size() && i < b + batch; ++i) {
+            // Validity depends on the cell alone, so it is checked once per
+            // cell rather than once per pair
+            for (size_t a = 0; a < attrs.size(); ++a)
+                valid[a] = isValid(attrs[a], pool.str(data[i][a]));
+            for (size_t main = 0; main < attrs.size(); ++main) {
+                correlate(i, main, valid);
+            }
         }
     }
 }
 
+void Compensative::move_statistics_to(ModelSnapshot& model) {
+    model.frequency = std::move(Frequency_list);
+    model.occurrence = std::move(Occurrence_list);
+    model.occurrence1 = std::move(Occurrence_1);
+    Frequency_list.clear();
+    Occurrence_list.clear();
+    Occurrence_1.clear();
+}
+
+map<string, size_t> Compensative::memory_footprint() const {
+    return {{"rows", footprint(data)},
+            {"frequency", footprint(Frequency_list)},
+            {"occurrence", footprint(Occurrence_list)},
+            {"occurrence1", footprint(Occurrence_1)}};
+}
+
 bool Compensative::isValid(const std::string& attr, const std::string& value) {
     const AttrInfo& info = attrs_type.at(attr);
-    bool allowNull = (info.allowNull == "Y");
-    std::string pattern = info.pattern;
 
-    if (!allowNull && value == "A Null Cell")
+    if (!info.allowNull && value == "A Null Cell")
         return false;
 
-    if (!pattern.empty()) {
-        try {
-            std::regex regex_pattern(pattern);
-            return std::regex_match(value, regex_pattern);
-        } catch (...) {
-            return false;
-        }
+    if (!info.pattern.empty()) {
+        // An invalid pattern accepts nothing
+        return info.compiled && std::regex_match(value, *info.compiled);
     }
 
     return true;
 }
 
-void Compensative::correlate(int row_index, const std::string& attr_main) {
+void Compensative::correlate(size_t row_index, size_t main, const vector<char>& valid) {
+    const InternPool& pool = InternPool::global();
     int weight = attrs_type.size() * attrs_type.size();
     double pen_weight = weight;
     double confident = 1.0;
 
-    const std::string& main_val = data[row_index].at(attr_main);
+    const vector<InternId>& row = data[row_index];
+    const std::string& main_val = pool.str(row[main]);
 
-    if (!isValid(attr_main, main_val)) {
+    if (!valid[main]) {
         pen_weight -= 2.0 * weight * weight;
         confident = 0;
     }
 
-    auto& occ_main = Occurrence_list[attr_main][main_val];
-    auto& occ1_main = Occurrence_1[attr_main][main_val];
+    auto& occ_main = Occurrence_list[attrs[main]][main_val];
+    auto& occ1_main = Occurrence_1[attrs[main]][main_val];
 
-    for (const auto& [attr_vice, _] : data[row_index]) {
-        if (attr_main == attr_vice) continue;
+    for (size_t vice = 0; vice < attrs.size(); ++vice) {
+        if (vice == main) continue;
 
-        const std::string& vice_val = data[row_index].at(attr_vice);
-        if (!isValid(attr_vice, vice_val)) {
+        const std::string& attr_vice = attrs[vice];
+        const std::string& vice_val = pool.str(row[vice]);
+        if (!valid[vice]) {
             confident *= 0.5;
             pen_weight -= 2.0 * weight;
         }
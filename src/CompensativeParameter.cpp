@@ -1,4 +1,6 @@
 #include "CompensativeParameter.h"
+#include "MemoryFootprint.h"
+#include "Trace.h"
 #include <algorithm>
 #include <cmath>
 #include <iomanip>
@@ -8,7 +10,7 @@
 #include <vector>
 
 // Remove spaces and '%' characters
-static inline std::string canonical(std::string s)
+std::string CompensativeParameter::canonical(const std::string& s)
 {
     std::string out;
     for (char ch : s)
@@ -21,17 +23,20 @@ static inline std::string canonical(std::string s)
 int CompensativeParameter::levenshtein_distance(const std::string &a,
                                                 const std::string &b)
 {
+    // Two rolling rows of the (n+1) x (m+1) DP table
     const size_t n = a.size(), m = b.size();
-    std::vector<std::vector<int>> d(n + 1, std::vector<int>(m + 1));
-    for (size_t i = 0; i <= n; ++i) d[i][0] = i;
-    for (size_t j = 0; j <= m; ++j) d[0][j] = j;
+    std::vector<int> prev(m + 1), cur(m + 1);
+    for (size_t j = 0; j <= m; ++j) prev[j] = j;
 
-    for (size_t i = 1; i <= n; ++i)
+    for (size_t i = 1; i <= n; ++i) {
+        cur[0] = i;
         for (size_t j = 1; j <= m; ++j)
-            d[i][j] = std::min({d[i - 1][j] + 1,
-                                d[i][j - 1] + 1,
-                                d[i - 1][j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1)});
-    return d[n][m];
+            cur[j] = std::min({prev[j] + 1,
+                               cur[j - 1] + 1,
+                               prev[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1)});
+        std::swap(prev, cur);
+    }
+    return prev[m];
 }
 
 // L2‑norm of a vector<double>
@@ -43,35 +48,51 @@ double CompensativeParameter::euclidean_norm(const std::vector<double> &v)
 }
 
 CompensativeParameter::CompensativeParameter(const map<string, AttrInfo>& attr_type,
-                                             const unordered_map<string, unordered_map<string, int>>& domain,
-                                             const unordered_map<string,
-                                                unordered_map<string,
-                                                    unordered_map<string,
-                                                        unordered_map<string, double>>>>& occurrence,
-                                             const BNGraph& model,
-                                             const DataFrame& df)
-    : attr_type(attr_type), domain(domain), occurrence(occurrence), model(model), df(df)
+                                             ModelSnapshotPtr model_snapshot,
+                                             const EncodedTable& df)
+    : attr_type(attr_type), snapshot(std::move(model_snapshot)), domain(snapshot->frequency),
+      occurrence(snapshot->occurrence), model(snapshot->full_graph), df(df)
 {
+    for (const auto &kv : attr_type)
+        attr_ids.emplace_back(kv.first, df.schema() ? df.schema()->attr_id(kv.first) : -1);
     // tf_idf is initially empty.
 }
 
+std::map<std::string, size_t> CompensativeParameter::memory_footprint() const
+{
+    // TFIDFData is not a standard container, so its map is summed by hand
+    size_t tfidf = tf_idf.bucket_count() * sizeof(void *);
+    for (const auto &kv : tf_idf)
+    {
+        tfidf += sizeof(void *) + sizeof(kv) + sizeof(size_t) + footprint(kv.first);
+        if (kv.second)
+            tfidf += sizeof(TFIDFData) + footprint(kv.second->combine_attrs) + footprint(kv.second->combine_ids) +
+                     footprint(kv.second->dic) + footprint(kv.second->dic_idf);
+    }
+    return {{"table", df.memory_footprint()},
+            {"tf_idf", tfidf}};
+}
+
 std::unordered_map<std::string, double>
 CompensativeParameter::return_penalty(const std::string &obs,
                                       const std::string &attr,
                                       int /*rowIdx*/,
-                                      const Row &row,
+                                      RowSpan row,
                                       const std::vector<std::string> &prior)
 {
+    TRACE_SCOPE("return_penalty");
     using std::string;
     std::unordered_map<string,double> score;                 // result
     if (!occurrence.count(attr)) {
-        std::cout << "[DEBUG] Attribute '" << attr << "' not in occurrence list\n";
+        if (debug)
+            std::cout << "[DEBUG] Attribute '" << attr << "' not in occurrence list\n";
         return score;
     }
 
     string obs_norm = canonical(
-        (obs == "A Null Cell" && attr_type.at(attr).allowNull == "N") ? "" : obs);
-    std::cout << "[DEBUG] Normalized observation: " << obs_norm << '\n';
+        (obs == "A Null Cell" && !attr_type.at(attr).allowNull) ? "" : obs);
+    if (debug)
+        std::cout << "[DEBUG] Normalized observation: " << obs_norm << '\n';
 
     auto is_related = [&](const string &other)->bool {
         if (model.adjacency_list.count(attr) &&
@@ -82,6 +103,15 @@ CompensativeParameter::return_penalty(const std::string &obs,
         return false;
     };
 
+    // Context of the row: the unrelated attributes and their canonical
+    // values, the same for every candidate
+    std::vector<std::pair<const string *, string>> context;
+    for (const auto &[other, other_id] : attr_ids) {
+        if (other == attr || is_related(other)) continue;
+        context.emplace_back(&other, canonical(df.schema()->dict(other_id).decode(row[other_id])));
+    }
+    const auto &occ_attr = occurrence.at(attr);
+
     // Compute a raw compensative score per candidate
     std::unordered_map<string,double> raw_map;
     double tot_raw = 0.0;
@@ -95,16 +125,12 @@ CompensativeParameter::return_penalty(const std::string &obs,
 
         //---------------- co‑occurrence -------------------
         std::vector<double> vec;
-        for (const auto &ap : attr_type) {
-            const string &other = ap.first;
-            if (other == attr || is_related(other)) continue;
-
-            const std::string other_val_raw = row.at(other);
-            const std::string other_val     = canonical(other_val_raw);
+        auto occ_cand_it = occ_attr.find(cand_norm);
+        for (const auto &[other_ptr, other_val] : context) {
+            const string &other = *other_ptr;
 
             double w = 0.0;
-            auto occ_cand_it = occurrence.at(attr).find(cand_norm);
-            if (occ_cand_it != occurrence.at(attr).end()) {
+            if (occ_cand_it != occ_attr.end()) {
                 auto oth_it = occ_cand_it->second.find(other);
                 if (oth_it != occ_cand_it->second.end()) {
                     auto val_it = oth_it->second.find(other_val);
@@ -113,8 +139,9 @@ CompensativeParameter::return_penalty(const std::string &obs,
                 }
             }
             vec.push_back(w);
-            std::cout << "    [DEBUG] Co-Occurrence (" << other << ", "
-                      << other_val << ")" << '\n';
+            if (debug)
+                std::cout << "    [DEBUG] Co-Occurrence (" << other << ", "
+                          << other_val << ")" << '\n';
         }
 
         constexpr double GAMMA = 1.5;
@@ -123,40 +150,44 @@ CompensativeParameter::return_penalty(const std::string &obs,
         raw_map[cand_raw] = raw;
         tot_raw += raw;
 
-        std::cout << "  [DEBUG] Candidate: "   << cand_raw
-                  << ", Canonical: "           << cand_norm
-                  << ", Edit Distance: "       << dist
-                  << ", Domain Term: "         << dom_term
-                  << "\n  [DEBUG] Candidate: " << cand_raw << '\n';
+        if (debug)
+            std::cout << "  [DEBUG] Candidate: "   << cand_raw
+                      << ", Canonical: "           << cand_norm
+                      << ", Edit Distance: "       << dist
+                      << ", Domain Term: "         << dom_term
+                      << "\n  [DEBUG] Candidate: " << cand_raw << '\n';
     }
 
     // Validity / pattern check  +  normalisation
     const auto &meta = attr_type.at(attr);
     for (const auto &cand_raw : prior) {
-        bool okNull = meta.allowNull == "Y" || cand_raw != "A Null Cell";
-        bool okPat  = meta.pattern.empty() ||
-                      std::regex_search(canonical(cand_raw),
-                                         std::regex(meta.pattern));
+        bool okNull = meta.allowNull || cand_raw != "A Null Cell";
+        bool okPat  = !meta.compiled ||
+                      std::regex_search(canonical(cand_raw), *meta.compiled);
 
         double comp = tot_raw ? raw_map[cand_raw] / tot_raw : 0.0;
 
         if (!okNull) {
             comp = 0.0;
-            std::cout << "[DEBUG] Candidate '" << cand_raw
-                      << "' invalid (okNull=0, okPat=" << okPat << "), score=0.\n";
+            if (debug)
+                std::cout << "[DEBUG] Candidate '" << cand_raw
+                          << "' invalid (okNull=0, okPat=" << okPat << "), score=0.\n";
         } else if (!okPat) {
             comp *= 0.1;
-            std::cout << "[DEBUG] Candidate '" << cand_raw
-                      << "' soft penalized for pattern mismatch, normalized score: "
-                      << comp << '\n';
+            if (debug)
+                std::cout << "[DEBUG] Candidate '" << cand_raw
+                          << "' soft penalized for pattern mismatch, normalized score: "
+                          << comp << '\n';
         } else {
-            std::cout << "[DEBUG] Candidate '" << cand_raw
-                      << "' valid, normalized score: " << comp << '\n';
+            if (debug)
+                std::cout << "[DEBUG] Candidate '" << cand_raw
+                          << "' valid, normalized score: " << comp << '\n';
         }
         score[cand_raw] = comp;
     }
 
-    std::cout << "[DEBUG] return_penalty finished.\n";
+    if (debug)
+        std::cout << "[DEBUG] return_penalty finished.\n";
     return score;
 }
 
@@ -164,10 +195,11 @@ std::unordered_map<std::string, double>
 CompensativeParameter::return_penalty_test(const std::string &obs,
                                            const std::string &attr,
                                            int /*rowIdx*/,
-                                           const Row &row,
+                                           RowSpan row,
                                            const std::vector<std::string> &prior,
                                            const std::vector<std::string> &)
 {
+    TRACE_SCOPE("return_penalty_test");
     std::unordered_map<std::string, double> out;
     if (!tf_idf.count(attr) || tf_idf[attr] == nullptr) {
         for (auto &c : prior) out[c] = 1;
@@ -177,10 +209,9 @@ CompensativeParameter::return_penalty_test(const std::string &obs,
 
     // Build comma-separated context values safely
     std::string ctx;
-    for (auto &at : tfidf->combine_attrs) {
-        auto it = row.find(at);
-        if (it != row.end()) {
-            ctx += "," + canonical(it->second);
+    for (int id : tfidf->combine_ids) {
+        if (id >= 0) {
+            ctx += "," + canonical(df.schema()->dict(id).decode(row[id]));
         } else {
             ctx += ",A Null Cell"; 
         }
@@ -193,7 +224,7 @@ CompensativeParameter::return_penalty_test(const std::string &obs,
 
         int idfc = tfidf->dic_idf.count(canonical(obs))
                    ? tfidf->dic_idf[canonical(obs)] : 0;
-        double idf = std::log((double)df.rows.size() / (idfc + 1));
+        double idf = std::log((double)df.num_rows() / (idfc + 1));
         if (!idf) continue;
 
         out[cand] = tf * idf;
@@ -201,16 +232,6 @@ CompensativeParameter::return_penalty_test(const std::string &obs,
     return out;
 }
 
-// Helper: count values in a DataFrame column
-static std::unordered_map<std::string, int>
-value_counts(const DataFrame &df, size_t colIdx)
-{
-    std::unordered_map<std::string, int> mp;
-    for (const auto &r : df.rows)
-        if (colIdx < r.size()) mp[r[colIdx]]++;
-    return mp;
-}
-
 void CompensativeParameter::init_tf_idf(const std::vector<std::string> &order)
 {
     for (auto &pr : attr_type) {
@@ -233,65 +254,43 @@ void CompensativeParameter::init_tf_idf(const std::vector<std::string> &order)
         return res;
     };
 
+        const std::vector<std::string> ps = parents(attr);
+        const std::vector<std::string> cs = children(attr);
         for (auto &at : order)
             if (at != attr &&
-                (std::count(parents(attr).begin(), parents(attr).end(), at) ||
-                 std::count(children(attr).begin(), children(attr).end(), at)))
+                (std::count(ps.begin(), ps.end(), at) ||
+                 std::count(cs.begin(), cs.end(), at)))
                 comb.push_back(at);
 
         if (comb.empty())
             for (auto &kv : attr_type)
                 if (kv.first != attr) comb.push_back(kv.first);
 
-        //--------------------- build context column -----------------
-        std::string ctxCol;
-        for (size_t i = 0; i < comb.size(); ++i) {
-            ctxCol += comb[i];
-            if (i + 1 < comb.size()) ctxCol += "_";
+        //--------------------- count context keys -----------------
+        // Each row contributes the key "attr,ctx1,ctx2,..." built from
+        // canonical values, and its raw attr value for the idf counts.
+        auto tf = std::make_shared<TFIDFData>();
+        tf->combine_attrs = comb;
+        for (auto &at : comb)
+            tf->combine_ids.push_back(df.schema()->attr_id(at));
+
+        int attrId = df.schema()->attr_id(attr);
+        if (attrId < 0) {
+            tf_idf[attr] = tf;
+            continue;
         }
-        ctxCol += "_TempAttribute";
-
-        DataFrame df2 = df;               
-        if (!std::count(df2.columns.begin(), df2.columns.end(), ctxCol))
-            df2.columns.push_back(ctxCol);
-
-        size_t ctxIdx =
-            std::find(df2.columns.begin(), df2.columns.end(), ctxCol) -
-            df2.columns.begin();
-        size_t attrIdx =
-            std::find(df2.columns.begin(), df2.columns.end(), attr) -
-            df2.columns.begin();
-
-        // Fill context column
-        for (auto &r : df2.rows) {
-            if (r.size() < df2.columns.size()) r.resize(df2.columns.size(), "");
+
+        for (size_t r = 0; r < df.num_rows(); ++r) {
+            RowSpan row = df.row(r);
             std::string acc;
-            for (auto &at : comb) {
-                size_t i = std::find(df2.columns.begin(), df2.columns.end(), at) -
-                           df2.columns.begin();
-                acc += (acc.empty() ? "" : ",") + canonical(r[i]);
+            for (int id : tf->combine_ids) {
+                const std::string &v = id >= 0 ? df.schema()->dict(id).decode(row[id]) : "";
+                acc += (acc.empty() ? "" : ",") + canonical(v);
             }
-            r[ctxIdx] = acc;
-        }
-
-        // Build obs column
-        std::string obsCol = attr + "_" + ctxCol;
-        if (!std::count(df2.columns.begin(), df2.columns.end(), obsCol))
-            df2.columns.push_back(obsCol);
-        size_t obsIdx =
-            std::find(df2.columns.begin(), df2.columns.end(), obsCol) -
-            df2.columns.begin();
-
-        for (auto &r : df2.rows) {
-            if (r.size() < df2.columns.size()) r.resize(df2.columns.size(), "");
-            r[obsIdx] = canonical(r[attrIdx]) + "," + r[ctxIdx];
+            const std::string &obs = df.schema()->dict(attrId).decode(row[attrId]);
+            tf->dic[canonical(obs) + "," + acc]++;
+            tf->dic_idf[obs]++;
         }
-
-        //--------------------- compute counts -----------------------
-        auto tf = std::make_shared<TFIDFData>();
-        tf->combine_attrs = comb;
-        tf->dic     = value_counts(df2, obsIdx);
-        tf->dic_idf = value_counts(df2, attrIdx);
         tf_idf[attr] = tf;
     }
-}
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "../include/ConstraintDetector.h"
+#include "../include/ThreadPool.h"
+#include <algorithm>
+#include <cstdlib>
+
+static const char* const kNullCell = "A Null Cell";
+
+// Leading number of s, as std::stod reads it; false if there is none
+static bool leading_number(const std::string& s, double& out)
+{
+    const char* begin = s.c_str();
+    char* end = nullptr;
+    out = std::strtod(begin, &end);
+    return end != begin;
+}
+
+//--------------------------- CompiledConstraint ------------------------------
+
+CompiledConstraint CompiledConstraint::compile(const AttrInfo& info)
+{
+    CompiledConstraint c;
+    c.numeric = info.numerical;
+    c.allow_null = info.allowNull;
+    c.min = info.min_v;
+    c.max = info.max_v;
+    c.pattern = info.compiled;
+    return c;
+}
+
+uint8_t CompiledConstraint::check(const std::string& value) const
+{
+    if (value == kNullCell)
+        return allow_null ? 0 : kNullViolation;
+
+    uint8_t bits = 0;
+    if (numeric) {
+        double v;
+        if (!leading_number(value, v))
+            bits |= kTypeViolation;
+        else if (v < min || v > max)
+            bits |= kRangeViolation;
+    } else {
+        double len = double(value.size());
+        if (len < min || len > max)
+            bits |= kLengthViolation;
+    }
+    if (pattern && !std::regex_search(value, *pattern))
+        bits |= kPatternViolation;
+    return bits;
+}
+
+//---------------------------- ViolationBitmap --------------------------------
+
+ViolationBitmap::ViolationBitmap(size_t num_rows, size_t num_attrs)
+    : rows(num_rows), bits(num_attrs, std::vector<uint64_t>((num_rows + 63) / 64, 0)) {}
+
+size_t ViolationBitmap::count() const
+{
+    size_t total = 0;
+    for (const auto& col : bits)
+        for (uint64_t w : col)
+            total += __builtin_popcountll(w);
+    return total;
+}
+
+//--------------------------- ConstraintDetector ------------------------------
+
+ConstraintDetector::ConstraintDetector(const std::shared_ptr<EncodedSchema>& schema,
+                                       const std::map<std::string, AttrInfo>& attr_type)
+    : schema(schema),
+      constrained(schema->num_attrs(), 0),
+      constraints(schema->num_attrs()),
+      code_bits(schema->num_attrs())
+{
+    for (const auto& kv : attr_type) {
+        int id = schema->attr_id(kv.first);
+        if (id < 0)
+            continue;
+        constrained[id] = 1;
+        constraints[id] = CompiledConstraint::compile(kv.second);
+    }
+}
+
+void ConstraintDetector::refresh_codes(int attr)
+{
+    const ValueDictionary& dict = schema->dict(attr);
+    auto& bits = code_bits[attr];
+    for (size_t code = bits.size(); code < dict.size(); ++code)
+        bits.push_back(constraints[attr].check(dict.decode(ValueCode(code))));
+}
+
+ViolationBitmap ConstraintDetector::detect(const EncodedTable& table, int num_worker)
+{
+    const size_t n = table.num_rows();
+    const size_t m = table.num_attrs();
+    ViolationBitmap out(n, m);
+    if (!schema || n == 0)
+        return out;
+
+    ThreadPool pool(num_worker > 0 ? num_worker : 1);
+    pool.run(m, [&](size_t a) {
+        if (!constrained[a])
+            return;
+        refresh_codes(int(a));
+        const uint8_t* flags = code_bits[a].data();
+        const size_t flag_count = code_bits[a].size();
+        const ValueCode* cells = table.row(0).codes + a;
+
+        // 64 cells per word, each a lookup of its code's bits
+        auto& words = out.column(int(a));
+        for (size_t w = 0; w < words.size(); ++w) {
+            const size_t base = w * 64;
+            const size_t count = std::min<size_t>(64, n - base);
+            uint64_t word = 0;
+            for (size_t k = 0; k < count; ++k) {
+                ValueCode c = cells[(base + k) * m];
+                uint64_t hit = c < flag_count ? flags[c] != 0 : 0;
+                word |= hit << k;
+            }
+            words[w] = word;
+        }
+    });
+    return out;
+}
+
+uint8_t ConstraintDetector::violations(int attr, ValueCode code) const
+{
+    if (attr < 0 || size_t(attr) >= constrained.size() || !constrained[attr] || code == kNoCode)
+        return 0;
+    if (code < code_bits[attr].size())
+        return code_bits[attr][code];
+    return constraints[attr].check(schema->dict(attr).decode(code));
+}
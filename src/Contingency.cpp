@@ -0,0 +1,111 @@
+#include "../include/Contingency.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+CodedColumns CodedColumns::encode(const DataFrame& data)
+{
+    CodedColumns cols;
+    cols.num_rows = data.rows.size();
+    size_t m = data.rows.empty() ? 0 : data.rows[0].size();
+    cols.codes.resize(m);
+    cols.values.resize(m);
+    cols.counts.resize(m);
+
+    for (size_t a = 0; a < m; ++a) {
+        // Number values by first appearance, then renumber by sorted value
+        std::unordered_map<std::string, uint32_t> index;
+        std::vector<std::string> seen;
+        std::vector<uint32_t> first(cols.num_rows);
+        for (size_t r = 0; r < cols.num_rows; ++r) {
+            const std::string& v = data.rows[r][a];
+            auto it = index.find(v);
+            if (it == index.end()) {
+                it = index.emplace(v, uint32_t(seen.size())).first;
+                seen.push_back(v);
+            }
+            first[r] = it->second;
+        }
+
+        std::vector<uint32_t> order(seen.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(),
+                  [&](uint32_t x, uint32_t y) { return seen[x] < seen[y]; });
+        std::vector<uint32_t> rank(seen.size());
+        for (uint32_t k = 0; k < order.size(); ++k)
+            rank[order[k]] = k;
+
+        auto& values = cols.values[a];
+        values.reserve(seen.size());
+        for (uint32_t k : order)
+            values.push_back(std::move(seen[k]));
+
+        auto& codes = cols.codes[a];
+        auto& counts = cols.counts[a];
+        codes.resize(cols.num_rows);
+        counts.assign(values.size(), 0);
+        for (size_t r = 0; r < cols.num_rows; ++r) {
+            codes[r] = rank[first[r]];
+            counts[codes[r]]++;
+        }
+    }
+    return cols;
+}
+
+PairCounts::PairCounts(const CodedColumns& cols, size_t i, size_t j)
+    : ci(cols.cardinality(i)), cj(cols.cardinality(j))
+{
+    const auto& a = cols.codes[i];
+    const auto& b = cols.codes[j];
+    const size_t n = cols.num_rows;
+    const size_t limit = std::min(std::max(kDenseRowFactor * n, kDenseMinCells), kDenseMaxCells);
+
+    is_dense = ci * cj <= limit;
+    if (is_dense) {
+        cells.assign(ci * cj, 0);
+        for (size_t r = 0; r < n; ++r)
+            cells[size_t(a[r]) * cj + b[r]]++;
+        return;
+    }
+
+    std::unordered_map<uint64_t, int> joint;
+    joint.reserve(std::min(n, ci * cj));
+    for (size_t r = 0; r < n; ++r)
+        joint[(uint64_t(a[r]) << 32) | b[r]]++;
+    sparse_keys.reserve(joint.size());
+    for (const auto& kv : joint)
+        sparse_keys.push_back(kv.first);
+    std::sort(sparse_keys.begin(), sparse_keys.end());
+    sparse_counts.reserve(sparse_keys.size());
+    for (uint64_t k : sparse_keys)
+        sparse_counts.push_back(joint[k]);
+}
+
+double mutual_information(const CodedColumns& cols, size_t i, size_t j)
+{
+    return mutual_information_estimate(cols, i, j).mi;
+}
+
+MIEstimate mutual_information_estimate(const CodedColumns& cols, size_t i, size_t j)
+{
+    const double n = cols.num_rows;
+    const auto& count_i = cols.counts[i];
+    const auto& count_j = cols.counts[j];
+
+    double mi = 0.0, second = 0.0;
+    PairCounts(cols, i, j).for_each([&](uint32_t vi, uint32_t vj, int c) {
+        double p_ij = (double)c / n;
+        double p_i = (double)count_i[vi] / n;
+        double p_j = (double)count_j[vj] / n;
+        double l = std::log((p_ij / (p_i * p_j)) + 1e-9);
+        mi += p_ij * l;
+        second += p_ij * l * l;
+    });
+
+    MIEstimate est;
+    est.mi = mi;
+    if (n > 0)
+        est.variance = std::max(0.0, second - mi * mi) / n;
+    return est;
+}
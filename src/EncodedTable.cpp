@@ -0,0 +1,118 @@
+#include "../include/EncodedTable.h"
+#include "../include/MemoryFootprint.h"
+#include <algorithm>
+
+ValueCode ValueDictionary::encode(const std::string& value) {
+    auto it = index_.find(value);
+    if (it != index_.end())
+        return it->second;
+    ValueCode code = static_cast<ValueCode>(values_.size());
+    InternPool& pool = InternPool::global();
+    const std::string& stored = pool.str(pool.intern(value));
+    index_.emplace(std::string_view(stored), code);
+    values_.push_back(&stored);
+    return code;
+}
+
+ValueCode ValueDictionary::lookup(const std::string& value) const {
+    auto it = index_.find(value);
+    return it == index_.end() ? kNoCode : it->second;
+}
+
+void ValueDictionary::truncate(size_t size) {
+    while (values_.size() > size) {
+        index_.erase(std::string_view(*values_.back()));
+        values_.pop_back();
+    }
+}
+
+size_t ValueDictionary::memory_footprint() const {
+    return footprint(index_) + footprint(values_);
+}
+
+size_t EncodedSchema::memory_footprint() const {
+    size_t bytes = footprint(attrs_) + footprint(attrIndex_) + dicts_.capacity() * sizeof(ValueDictionary);
+    for (const auto& d : dicts_)
+        bytes += d.memory_footprint();
+    return bytes;
+}
+
+EncodedSchema::EncodedSchema(const std::vector<std::string>& attrs)
+    : attrs_(attrs), dicts_(attrs.size())
+{
+    for (size_t i = 0; i < attrs_.size(); ++i)
+        attrIndex_[attrs_[i]] = static_cast<int>(i);
+}
+
+int EncodedSchema::attr_id(const std::string& name) const {
+    auto it = attrIndex_.find(name);
+    return it == attrIndex_.end() ? -1 : it->second;
+}
+
+EncodedTable::EncodedTable(std::shared_ptr<EncodedSchema> schema)
+    : schema_(std::move(schema)) {}
+
+EncodedTable EncodedTable::encode(const DataFrame& df,
+                                  const std::shared_ptr<EncodedSchema>& schema,
+                                  const std::string& null_value) {
+    EncodedTable table(schema);
+    table.append(df, null_value);
+    return table;
+}
+
+void EncodedTable::append(const DataFrame& df, const std::string& null_value) {
+    const size_t m = num_attrs();
+
+    // Column of df holding each schema attribute, or -1 if absent
+    std::vector<int> source(m, -1);
+    for (size_t j = 0; j < df.columns.size(); ++j) {
+        int id = schema_->attr_id(df.columns[j]);
+        if (id >= 0)
+            source[id] = static_cast<int>(j);
+    }
+
+    cells_.reserve(cells_.size() + df.rows.size() * m);
+    for (const auto& row : df.rows) {
+        for (size_t a = 0; a < m; ++a) {
+            int j = source[a];
+            const std::string& cell = (j >= 0 && j < (int)row.size()) ? row[j] : null_value;
+            if (cell.empty() && !null_value.empty())
+                cells_.push_back(schema_->dict(a).encode(null_value));
+            else
+                cells_.push_back(schema_->dict(a).encode(cell));
+        }
+        ++numRows_;
+    }
+}
+
+EncodedTable EncodedTable::slice(size_t begin, size_t end) const {
+    EncodedTable out(schema_);
+    end = std::min(end, numRows_);
+    if (begin >= end)
+        return out;
+    out.cells_.assign(cells_.begin() + begin * num_attrs(), cells_.begin() + end * num_attrs());
+    out.numRows_ = end - begin;
+    return out;
+}
+
+void EncodedTable::append_row(const std::vector<std::string>& values) {
+    for (size_t a = 0; a < num_attrs(); ++a)
+        cells_.push_back(schema_->dict(a).encode(a < values.size() ? values[a] : ""));
+    ++numRows_;
+}
+
+DataFrame EncodedTable::decode() const {
+    DataFrame df;
+    if (!schema_)
+        return df;
+    df.columns = schema_->attrs();
+    df.rows.reserve(numRows_);
+    for (size_t i = 0; i < numRows_; ++i) {
+        std::vector<std::string> row;
+        row.reserve(num_attrs());
+        for (size_t a = 0; a < num_attrs(); ++a)
+            row.push_back(value(i, a));
+        df.rows.push_back(std::move(row));
+    }
+    return df;
+}
@@ -0,0 +1,381 @@
+#include "../include/HillClimb.h"
+#include "../include/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <unordered_map>
+
+//------------------------------ FamilyScorer ---------------------------------
+
+FamilyScorer::FamilyScorer(const CodedColumns& cols, Kind kind, double equivalent_sample_size)
+    : cols(cols), kind(kind), ess(equivalent_sample_size), cache(cols.num_attrs())
+{
+    for (size_t a = 0; a < cols.num_attrs(); ++a)
+        locks.emplace_back(new std::mutex);
+}
+
+double FamilyScorer::score(int node, const std::vector<int>& parents)
+{
+    {
+        std::lock_guard<std::mutex> lock(*locks[node]);
+        auto it = cache[node].find(parents);
+        if (it != cache[node].end())
+            return it->second;
+    }
+    // Two threads may score the same family; both get the same value
+    double s = compute(node, parents);
+    std::lock_guard<std::mutex> lock(*locks[node]);
+    cache[node].emplace(parents, s);
+    return s;
+}
+
+size_t FamilyScorer::cached_families() const
+{
+    size_t total = 0;
+    for (size_t a = 0; a < cache.size(); ++a) {
+        std::lock_guard<std::mutex> lock(*locks[a]);
+        total += cache[a].size();
+    }
+    return total;
+}
+
+double FamilyScorer::compute(int node, const std::vector<int>& parents) const
+{
+    const size_t n = cols.num_rows;
+    const size_t r = cols.cardinality(node);
+    const auto& child = cols.codes[node];
+    if (n == 0)
+        return 0.0;
+
+    // Parent configurations are numbered densely in order of appearance,
+    // one parent at a time, so only observed configurations are counted
+    std::vector<uint32_t> config(n, 0);
+    size_t q_obs = 1;
+    double q = 1.0;
+    for (int p : parents) {
+        q *= (double)cols.cardinality(p);
+        const auto& pc = cols.codes[p];
+        std::unordered_map<uint64_t, uint32_t> ids;
+        ids.reserve(std::min(n, q_obs * cols.cardinality(p)));
+        for (size_t row = 0; row < n; ++row) {
+            uint64_t key = (uint64_t(config[row]) << 32) | pc[row];
+            auto it = ids.emplace(key, uint32_t(ids.size())).first;
+            config[row] = it->second;
+        }
+        q_obs = ids.size();
+    }
+
+    std::vector<int> n_j(q_obs, 0);
+    for (size_t row = 0; row < n; ++row)
+        n_j[config[row]]++;
+
+    // Visits every non-zero N_jk with its configuration j
+    std::vector<int> dense;
+    std::unordered_map<uint64_t, int> sparse;
+    const bool use_dense = q_obs * r <= std::max(PairCounts::kDenseRowFactor * n,
+                                                 (size_t)PairCounts::kDenseMinCells);
+    if (use_dense) {
+        dense.assign(q_obs * r, 0);
+        for (size_t row = 0; row < n; ++row)
+            dense[size_t(config[row]) * r + child[row]]++;
+    } else {
+        for (size_t row = 0; row < n; ++row)
+            sparse[(uint64_t(config[row]) << 32) | child[row]]++;
+    }
+    auto for_each_cell = [&](auto fn) {
+        if (use_dense) {
+            for (size_t k = 0; k < dense.size(); ++k)
+                if (dense[k])
+                    fn(k / r, dense[k]);
+        } else {
+            for (const auto& kv : sparse)
+                fn(size_t(kv.first >> 32), kv.second);
+        }
+    };
+
+    double s = 0.0;
+    if (kind == Kind::BIC) {
+        for_each_cell([&](size_t j, int n_jk) {
+            s += n_jk * std::log((double)n_jk / n_j[j]);
+        });
+        s -= 0.5 * std::log((double)n) * q * (double)(r - 1);
+    } else {
+        const double a_j = ess / q;
+        const double a_jk = ess / (q * r);
+        for (size_t j = 0; j < q_obs; ++j)
+            s += std::lgamma(a_j) - std::lgamma(a_j + n_j[j]);
+        for_each_cell([&](size_t, int n_jk) {
+            s += std::lgamma(a_jk + n_jk) - std::lgamma(a_jk);
+        });
+    }
+    return s;
+}
+
+//----------------------------- HillClimbSearch -------------------------------
+
+static const double kMinImprovement = 1e-9;
+
+HillClimbSearch::HillClimbSearch(const CodedColumns& cols, const StructureOptions& options, int num_worker)
+    : cols(cols), options(options),
+      scorer(cols, options.score == "bdeu" ? FamilyScorer::Kind::BDeu : FamilyScorer::Kind::BIC,
+             options.equivalent_sample_size),
+      pool(new ThreadPool(num_worker > 0 ? num_worker : 1)),
+      m(int(cols.num_attrs())) {}
+
+HillClimbSearch::~HillClimbSearch() = default;
+
+std::vector<std::pair<int, int>> HillClimbSearch::run(const std::vector<std::pair<int, int>>& required)
+{
+    parents.assign(m, {});
+    edge.assign(size_t(m) * m, 0);
+    required_edge.assign(size_t(m) * m, 0);
+    node_score.assign(m, 0.0);
+    delta.assign(size_t(m) * m, 0.0);
+    tabu.clear();
+    applied_moves = 0;
+    best_parents = parents;
+    best_total = 0.0;
+    if (m < 2)
+        return {};
+
+    for (const auto& e : required) {
+        if (e.first == e.second || has_edge(e.first, e.second))
+            continue;
+        edge[size_t(e.first) * m + e.second] = 1;
+        required_edge[size_t(e.first) * m + e.second] = 1;
+        parents[e.second].push_back(e.first);
+    }
+    for (auto& p : parents)
+        std::sort(p.begin(), p.end());
+
+    refresh_all();
+    best_parents = parents;
+    best_total = total();
+    climb();
+
+    std::mt19937 rng(options.seed);
+    size_t perturbation = options.restart_moves > 0 ? options.restart_moves : m;
+    for (int restart = 0; restart < options.restarts; ++restart) {
+        // Restart from the best graph so far, shaken by random legal moves
+        parents = best_parents;
+        std::fill(edge.begin(), edge.end(), 0);
+        for (int v = 0; v < m; ++v)
+            for (int u : parents[v])
+                edge[size_t(u) * m + v] = 1;
+        refresh_all();
+        tabu.clear();
+
+        std::uniform_int_distribution<int> pick_node(0, m - 1);
+        std::uniform_int_distribution<int> pick_type(0, 2);
+        for (size_t done = 0, tries = 0; done < perturbation && tries < 20 * perturbation + 100; ++tries) {
+            Move mv{MoveType(pick_type(rng)), pick_node(rng), pick_node(rng), 0.0};
+            if (mv.u == mv.v)
+                continue;
+            if (mv.type != Add && !has_edge(mv.u, mv.v))
+                continue;
+            if (!legal(mv))
+                continue;
+            apply(mv);
+            done++;
+        }
+        climb();
+    }
+
+    std::vector<std::pair<int, int>> result;
+    for (int v = 0; v < m; ++v)
+        for (int u : best_parents[v])
+            result.emplace_back(u, v);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+void HillClimbSearch::climb()
+{
+    // Moves made since the best score last improved; a tabu search may
+    // walk through up to tabu_length of them before giving up
+    int stagnant = 0;
+    for (int iter = 0; iter < options.max_iter; ++iter) {
+        Move best;
+        if (!find_best(best))
+            break;
+        if (best.delta <= kMinImprovement && options.tabu_length <= 0)
+            break;
+        apply(best);
+
+        double t = total();
+        if (t > best_total + kMinImprovement) {
+            best_total = t;
+            best_parents = parents;
+            stagnant = 0;
+        } else if (++stagnant > options.tabu_length) {
+            break;
+        }
+    }
+}
+
+bool HillClimbSearch::find_best(Move& best) const
+{
+    bool found = false;
+    best.delta = -INFINITY;
+
+    auto consider = [&](const Move& mv) {
+        // Cheap score comparison first; reachability only for contenders
+        if (mv.delta <= best.delta)
+            return;
+        if (is_tabu(mv) || !legal(mv))
+            return;
+        best = mv;
+        found = true;
+    };
+
+    for (int u = 0; u < m; ++u) {
+        for (int v = 0; v < m; ++v) {
+            if (u == v)
+                continue;
+            const double d = delta[size_t(u) * m + v];
+            if (has_edge(u, v)) {
+                consider({Remove, u, v, d});
+                consider({Reverse, u, v, d + delta[size_t(v) * m + u]});
+            } else if (!has_edge(v, u)) {
+                consider({Add, u, v, d});
+            }
+        }
+    }
+    return found;
+}
+
+bool HillClimbSearch::legal(const Move& mv) const
+{
+    const int u = mv.u, v = mv.v;
+    switch (mv.type) {
+    case Add:
+        if (has_edge(u, v) || has_edge(v, u))
+            return false;
+        if ((int)parents[v].size() >= options.max_indegree)
+            return false;
+        return !reaches(v, u);
+    case Remove:
+        return has_edge(u, v) && !is_required(u, v);
+    case Reverse:
+        if (!has_edge(u, v) || is_required(u, v))
+            return false;
+        if ((int)parents[u].size() >= options.max_indegree)
+            return false;
+        // v -> u closes a cycle iff u still reaches v without u -> v
+        return !reaches(u, v, u, v);
+    }
+    return false;
+}
+
+void HillClimbSearch::apply(const Move& mv)
+{
+    const int u = mv.u, v = mv.v;
+    auto add_parent = [&](int child, int parent) {
+        auto& p = parents[child];
+        p.insert(std::upper_bound(p.begin(), p.end(), parent), parent);
+        edge[size_t(parent) * m + child] = 1;
+    };
+    auto remove_parent = [&](int child, int parent) {
+        auto& p = parents[child];
+        p.erase(std::find(p.begin(), p.end(), parent));
+        edge[size_t(parent) * m + child] = 0;
+    };
+
+    Move inverse = mv;
+    switch (mv.type) {
+    case Add:
+        add_parent(v, u);
+        inverse.type = Remove;
+        refresh_column(v);
+        break;
+    case Remove:
+        remove_parent(v, u);
+        inverse.type = Add;
+        refresh_column(v);
+        break;
+    case Reverse:
+        remove_parent(v, u);
+        add_parent(u, v);
+        inverse = {Reverse, v, u, 0.0};
+        refresh_column(v);
+        refresh_column(u);
+        break;
+    }
+
+    if (options.tabu_length > 0) {
+        tabu.push_back(inverse);
+        if ((int)tabu.size() > options.tabu_length)
+            tabu.erase(tabu.begin());
+    }
+    applied_moves++;
+}
+
+void HillClimbSearch::refresh_column(int v)
+{
+    node_score[v] = scorer.score(v, parents[v]);
+    pool->run(m, [&](size_t ui) {
+        int u = int(ui);
+        if (u == v)
+            return;
+        std::vector<int> p = parents[v];
+        auto it = std::lower_bound(p.begin(), p.end(), u);
+        if (it != p.end() && *it == u)
+            p.erase(it);
+        else
+            p.insert(it, u);
+        delta[size_t(u) * m + v] = scorer.score(v, p) - node_score[v];
+    });
+}
+
+void HillClimbSearch::refresh_all()
+{
+    pool->run(m, [&](size_t v) { node_score[v] = scorer.score(int(v), parents[v]); });
+    pool->run(size_t(m) * m, [&](size_t k) {
+        int u = int(k / m), v = int(k % m);
+        if (u == v)
+            return;
+        std::vector<int> p = parents[v];
+        auto it = std::lower_bound(p.begin(), p.end(), u);
+        if (it != p.end() && *it == u)
+            p.erase(it);
+        else
+            p.insert(it, u);
+        delta[k] = scorer.score(v, p) - node_score[v];
+    });
+}
+
+bool HillClimbSearch::reaches(int from, int to, int skip_u, int skip_v) const
+{
+    std::vector<char> seen(m, 0);
+    std::vector<int> stack{from};
+    seen[from] = 1;
+    while (!stack.empty()) {
+        int x = stack.back();
+        stack.pop_back();
+        for (int y = 0; y < m; ++y) {
+            if (!has_edge(x, y) || seen[y] || (x == skip_u && y == skip_v))
+                continue;
+            if (y == to)
+                return true;
+            seen[y] = 1;
+            stack.push_back(y);
+        }
+    }
+    return false;
+}
+
+bool HillClimbSearch::is_tabu(const Move& mv) const
+{
+    for (const auto& t : tabu)
+        if (t.type == mv.type && t.u == mv.u && t.v == mv.v)
+            return true;
+    return false;
+}
+
+double HillClimbSearch::total() const
+{
+    double t = 0.0;
+    for (double s : node_score)
+        t += s;
+    return t;
+}
@@ -1,16 +1,16 @@
 #include "../include/Inference.h"
 #include "../include/Compensative.h"
+#include "../include/MemoryFootprint.h"
+#include "../include/Trace.h"
 #include <iostream>
 #include <cmath>
 #include <algorithm>
+#include <chrono>
 
-Inference::Inference(const DataMap& dirtyData,
-                     const DataMap& processedData,
-                     const BNGraph& model,
-                     const unordered_map<string, BNGraph>& modelDict,
+Inference::Inference(const EncodedTable& dirtyData,
+                     const EncodedTable& processedData,
+                     ModelSnapshotPtr model,
                      const AttrType& attrType,
-                     const unordered_map<string, unordered_map<string,int>>& frequencyList,
-                     const unordered_map<string, unordered_map<string, unordered_map<string, unordered_map<string,int>>>>& occurrence1,
                      const shared_ptr<CompensativeParameter>& compParam,
                      const string& inferStrategy,
                      int chunkSize,
@@ -19,11 +19,12 @@ Inference::Inference(const DataMap& dirtyData,
                      bool debug)
   : dirtyData_(dirtyData),
     data_(processedData),
-    model_(model),
-    modelDict_(modelDict),
+    snapshot_(std::move(model)),
+    model_(snapshot_->full_graph),
+    modelDict_(snapshot_->partition_graphs),
     attrType_(attrType),
-    frequencyList_(frequencyList),
-    occurrence1_(occurrence1),
+    frequencyList_(snapshot_->frequency),
+    occurrence1_(snapshot_->occurrence1),
     compParam_(compParam),
     inferStrategy_(inferStrategy),
     chunkSize_(chunkSize),
@@ -31,51 +32,164 @@ Inference::Inference(const DataMap& dirtyData,
     tuplePrun_(tuplePrun),
     debug_(debug)
 {
+    buildAttrModels();
+    detector_ = ConstraintDetector(dirtyData_.schema(), attrType_);
+    violations_ = detector_.detect(dirtyData_, numWorker_);
+    std::cout << "Constraint violations: " << violations_.count()
+              << " cells" << std::endl;
     std::cout << "Inference initialized (strategy="
               << inferStrategy_
               << (debug_ ? ", DEBUG=ON)\n" : ")\n");
 }
 
-DataMap Inference::repair(const DataMap& /*data*/,
-                          const DataFrame& /*cleanData*/,
-                          const BNGraph& /*model*/,
-                          const AttrType& /*attrType*/)
+void Inference::buildAttrModels()
 {
+    const auto& schema = dirtyData_.schema();
+    attrModels_.assign(schema->num_attrs(), AttrModel{});
+
+    for (auto &kv : attrType_) {
+        int id = schema->attr_id(kv.first);
+        if (id < 0) continue;
+        nodes_.push_back(id);
+        const string& attr = kv.first;
+        AttrModel& am = attrModels_[id];
+        am.id = id;
+        // Encoded even if no training cell is null, so that null cells in
+        // rows encoded later are still recognized
+        am.nullCode = schema->dict(id).encode("A Null Cell");
 
-    std::cout << "Starting repair..." << std::endl;
+        auto freqIt = frequencyList_.find(attr);
+        if (freqIt == frequencyList_.end())
+            continue;
+
+        // Candidates and their marginal log-probabilities
+        double sum = 0;
+        for (auto &pp : freqIt->second)
+            sum += pp.second;
+        for (auto &pp : freqIt->second) {
+            am.candidates.push_back(pp.first);
+            am.candidateCodes.push_back(schema->dict(id).encode(pp.first));
+            double p = (sum > 0 ? pp.second / sum : 0.0);
+            am.marginalLog.push_back(std::log(p + 1e-9));
+        }
+
+        // Parents of attr in its partition graph
+        auto mdIt = modelDict_.find(attr);
+        if (mdIt != modelDict_.end()) {
+            for (auto &pk : mdIt->second.adjacency_list) {
+                int pid = schema->attr_id(pk.first);
+                if (pk.second.count(attr) && pid >= 0)
+                    am.parentIds.push_back(pid);
+            }
+        }
 
-    // Build the list of attributes to consider
-    vector<string> nodes;
-    for (auto &kv : attrType_) nodes.push_back(kv.first);
+        // Joint counts occurrence1_[attr][v][p][pv] and parent marginals
+        // frequencyList_[p][pv], re-keyed by code
+        auto o1a = occurrence1_.find(attr);
+        for (int pid : am.parentIds) {
+            const string& p = schema->attr_name(pid);
+            const ValueDictionary& pdict = schema->dict(pid);
+
+            unordered_map<uint64_t, int> joint;
+            if (o1a != occurrence1_.end()) {
+                for (size_t c = 0; c < am.candidates.size(); ++c) {
+                    auto o1v = o1a->second.find(am.candidates[c]);
+                    if (o1v == o1a->second.end()) continue;
+                    auto o1p = o1v->second.find(p);
+                    if (o1p == o1v->second.end()) continue;
+                    for (auto &pv : o1p->second) {
+                        ValueCode code = pdict.lookup(pv.first);
+                        if (code != kNoCode)
+                            joint[(uint64_t(c) << 32) | code] = pv.second;
+                    }
+                }
+            }
+            am.joint.push_back(std::move(joint));
+
+            vector<int> counts(pdict.size(), 0);
+            auto pfl = frequencyList_.find(p);
+            if (pfl != frequencyList_.end()) {
+                for (auto &pv : pfl->second) {
+                    ValueCode code = pdict.lookup(pv.first);
+                    if (code != kNoCode)
+                        counts[code] = pv.second;
+                }
+            }
+            am.parentCount.push_back(std::move(counts));
+        }
 
-    // Copy & fill missing
-    DataMap repairData = dirtyData_;
-    for (auto &row : repairData) {
-        for (auto &n : nodes) {
-            if (row.find(n) == row.end() || row[n].empty())
-                row[n] = "A Null Cell";
+        if (am.parentIds.size() == 1) {
+            // Bucket the single joint table by parent code so a cell reads
+            // one contiguous range instead of probing per candidate
+            const auto& joint = am.joint[0];
+            const auto& pcount = am.parentCount[0];
+            am.treeOffset.assign(pcount.size() + 1, 0);
+            for (auto &kv : joint)
+                am.treeOffset[uint32_t(kv.first) + 1]++;
+            for (size_t pv = 0; pv < pcount.size(); ++pv)
+                am.treeOffset[pv + 1] += am.treeOffset[pv];
+            am.treeCand.resize(joint.size());
+            am.treeLog.resize(joint.size());
+            vector<uint32_t> fill(am.treeOffset.begin(), am.treeOffset.end() - 1);
+            for (auto &kv : joint) {
+                uint32_t pv = uint32_t(kv.first);
+                double pc = pcount[pv];
+                double cond = (pc > 0 ? kv.second / pc : 0.0);
+                am.treeCand[fill[pv]] = int(kv.first >> 32);
+                am.treeLog[fill[pv]] = std::log(cond + 1e-9);
+                fill[pv]++;
+            }
         }
     }
+}
+
+map<string, size_t> Inference::memory_footprint() const
+{
+    size_t models = attrModels_.capacity() * sizeof(AttrModel);
+    for (const AttrModel& am : attrModels_)
+        models += footprint(am.candidates) + footprint(am.candidateCodes) + footprint(am.marginalLog) +
+                  footprint(am.parentIds) + footprint(am.joint) + footprint(am.parentCount) +
+                  footprint(am.treeOffset) + footprint(am.treeCand) + footprint(am.treeLog);
+    return {{"tables", dirtyData_.memory_footprint() + data_.memory_footprint()},
+            {"attr_models", models}};
+}
+
+EncodedTable Inference::repair(const EncodedTable& /*data*/,
+                               const DataFrame& /*cleanData*/,
+                               const BNGraph& /*model*/,
+                               const AttrType& /*attrType*/)
+{
+    TRACE_SCOPE("repair");
+
+    std::cout << "Starting repair..." << std::endl;
+
+    // Attributes to consider
+    const vector<int>& nodes = nodes_;
+
+    // Missing cells were already filled with "A Null Cell" when encoding;
+    // repair writes into a flat copy of the codes
+    EncodedTable repairData = dirtyData_;
 
     // Repair every row
-    for (size_t i = 0; i < repairData.size(); ++i) {
-        auto fixed = repairLine(repairData[i],
-                                int(i),
-                                model_,
-                                modelDict_,
-                                nodes,
-                                attrType_);
-        repairData[i] = std::move(fixed);
+    for (size_t i = 0; i < repairData.num_rows(); ++i) {
+        repairLine(dirtyData_.row(i),
+                   repairData.row_data(i),
+                   int(i),
+                   model_,
+                   modelDict_,
+                   nodes,
+                   attrType_);
         if ((i+1) % 100 == 0)
             std::cout << (i+1) << " rows repaired\n";
     }
 
         if (debug_) {
         std::cout << "\n=== FINAL REPAIRED DATA ===\n";
-        for (size_t i = 0; i < repairData.size(); ++i) {
+        const auto& schema = repairData.schema();
+        for (size_t i = 0; i < repairData.num_rows(); ++i) {
             std::cout << "Row " << i << ": ";
-            for (auto &kv : repairData[i])
-                std::cout << kv.first << "=" << kv.second << "  ";
+            for (int id : nodes)
+                std::cout << schema->attr_name(id) << "=" << repairData.value(i, id) << "  ";
             std::cout << '\n';
         }
     }
@@ -83,166 +197,305 @@ DataMap Inference::repair(const DataMap& /*data*/,
     return repairData;
 }
 
-Row Inference::repairLine(const Row& dataLine,
-                          int line,
-                          const BNGraph& /*modelAll*/,
-                          const unordered_map<string,BNGraph>& /*modelDict*/,
-                          const vector<string>& nodeList,
-                          const AttrType& /*attrType*/)
+EncodedTable Inference::repair_rows(size_t begin, size_t end)
 {
-    Row repaired = dataLine;
+    TRACE_SCOPE_ARG("repair_rows", begin);
+    const vector<int>& nodes = nodes_;
+
+    EncodedTable out = dirtyData_.slice(begin, end);
+    for (size_t i = 0; i < out.num_rows(); ++i)
+        repairLine(dirtyData_.row(begin + i),
+                   out.row_data(i),
+                   int(begin + i),
+                   model_,
+                   modelDict_,
+                   nodes,
+                   attrType_);
+    return out;
+}
+
+void Inference::repair_row(RowSpan dataLine, ValueCode* repaired, int line)
+{
+    repairLine(dataLine, repaired, line, model_, modelDict_, nodes_, attrType_);
+}
 
+void Inference::repairLine(RowSpan dataLine,
+                           ValueCode* repaired,
+                           int line,
+                           const BNGraph& /*modelAll*/,
+                           const unordered_map<string,BNGraph>& /*modelDict*/,
+                           const vector<int>& nodeList,
+                           const AttrType& /*attrType*/)
+{
+    TRACE_SCOPE_ARG("repairLine", line);
     // 1) Which attrs need repair?
     auto toRepair = prun(dataLine, line, attrType_, nodeList);
 
-    for (auto &attr : toRepair) {
-        // 2) Gather candidates from frequencyList_
-        vector<string> candidates;
-        auto freqIt = frequencyList_.find(attr);
-        if (freqIt == frequencyList_.end()) {
-            // no data → skip
-            continue;
-        }
-        for (auto &kv : freqIt->second)
-            candidates.push_back(kv.first);
+    for (int id : toRepair) {
+        // 2) Score and pick top
+        int best = scoreCell(dataLine, id, line, true);
+        if (best >= 0)
+            repaired[id] = attrModels_[id].candidateCodes[best];
+    }
+}
 
-        // 3) Precompute parents for this attr
-        vector<string> parents;
-        auto mdIt = modelDict_.find(attr);
-        if (mdIt != modelDict_.end()) {
-            for (auto &kv : mdIt->second.adjacency_list) {
-                if (kv.second.count(attr))
-                    parents.push_back(kv.first);
+int Inference::scoreCell(RowSpan dataLine, int id, int line, bool withCompensative)
+{
+    const auto& schema = dirtyData_.schema();
+    const AttrModel& am = attrModels_[id];
+    const string& attr = schema->attr_name(id);
+    // Candidates come from frequencyList_
+    if (am.candidates.empty()) {
+        // no data → skip
+        return -1;
+    }
+
+    struct Cand { size_t idx; double bn, comp, final; };
+    vector<Cand> scored;
+    scored.reserve(am.candidates.size());
+
+    // Compensative penalty does not depend on the candidate being scored,
+    // so it is computed once per cell
+    unordered_map<string, double> penMap;
+    if (withCompensative)
+        penMap = compParam_->return_penalty(
+                     schema->dict(id).decode(dataLine[id]),
+                     attr,
+                     line,
+                     dataLine,
+                     am.candidates);
+
+    // One parent: P(c | parent) for every candidate from one bucket
+    vector<double> treeBn;
+    if (am.parentIds.size() == 1) {
+        treeBn.assign(am.candidates.size(), std::log(1e-9));
+        ValueCode pv = dataLine[am.parentIds[0]];
+        if (pv < am.treeOffset.size() - 1)
+            for (uint32_t k = am.treeOffset[pv]; k < am.treeOffset[pv + 1]; ++k)
+                treeBn[am.treeCand[k]] = am.treeLog[k];
+    }
+
+    // Score every candidate
+    for (size_t c = 0; c < am.candidates.size(); ++c) {
+        double bnLog = 0.0;
+
+        if (!treeBn.empty()) {
+            bnLog = treeBn[c];
+        } else if (am.parentIds.empty()) {
+            // marginal P(attr=v) = freq(v)/sum(freq)
+            bnLog = am.marginalLog[c];
+        } else {
+            // naive‐Bayes: ∏ P(v | parent = observed)
+            for (size_t k = 0; k < am.parentIds.size(); ++k) {
+                ValueCode pv = dataLine[am.parentIds[k]];
+
+                double joint = 0.0;
+                auto jit = am.joint[k].find((uint64_t(c) << 32) | pv);
+                if (jit != am.joint[k].end())
+                    joint = jit->second;
+
+                double pc = pv < am.parentCount[k].size() ? am.parentCount[k][pv] : 0.0;
+
+                double cond = (pc > 0 ? joint / pc : 0.0);
+                bnLog += std::log(cond + 1e-9);
             }
         }
 
-        struct Cand { string val; double bn, comp, final; };
-        vector<Cand> scored;
+        if (!withCompensative) {
+            scored.push_back({ c, bnLog, 0.0, bnLog });
+            continue;
+        }
 
-        // Score every candidate
-        for (auto &v : candidates) {
-            double bnLog = 0.0;
+        double compS = 0.0;
+        auto itp = penMap.find(am.candidates[c]);
+        if (itp != penMap.end())
+            compS = itp->second;
 
-            if (parents.empty()) {
-                // marginal P(attr=v) = freq(v)/sum(freq)
-                double freq_v = 0, sum = 0;
-                for (auto &pp : freqIt->second) {
-                    if (pp.first == v) freq_v = pp.second;
-                    sum += pp.second;
-                }
-                double p = (sum > 0 ? freq_v / sum : 0.0);
-                bnLog = std::log(p + 1e-9);
-            } else {
-                // naive‐Bayes: ∏ P(v | parent = observed)
-                for (auto &p : parents) {
-                    // observed parent value
-                    string pv = "";
-                    auto pit = dataLine.find(p);
-                    if (pit != dataLine.end())
-                        pv = pit->second;
-
-                    // joint count = occurrence1_[attr][v][p][pv], if present
-                    double joint = 0.0;
-                    auto o1a = occurrence1_.find(attr);
-                    if (o1a != occurrence1_.end()) {
-                        auto o1v = o1a->second.find(v);
-                        if (o1v != o1a->second.end()) {
-                            auto o1p = o1v->second.find(p);
-                            if (o1p != o1v->second.end()) {
-                                auto o1pv = o1p->second.find(pv);
-                                if (o1pv != o1p->second.end())
-                                    joint = o1pv->second;
-                            }
-                        }
-                    }
+        //double fS = bnLog + compS;
+        constexpr double LAMBDA = 6.0;
+        constexpr double EPS    = 1e-12; 
+        compS = std::max(compS, EPS);
+        double compLog = std::log(compS + EPS); 
+        double fS      = bnLog + LAMBDA * compLog;
 
-                    // parent marginal = frequencyList_[p][pv], if present
-                    double pc = 0.0;
-                    auto pfl = frequencyList_.find(p);
-                    if (pfl != frequencyList_.end()) {
-                        auto pit2 = pfl->second.find(pv);
-                        if (pit2 != pfl->second.end())
-                            pc = pit2->second;
-                    }
-
-                    double cond = (pc > 0 ? joint / pc : 0.0);
-                    bnLog += std::log(cond + 1e-9);
-                }
-            }
+        scored.push_back({ c, bnLog, compS, fS });
+    }
 
-            // compensative penalty
-            auto penMap = compParam_->return_penalty(
-                              dataLine.at(attr), 
-                              attr,
-                              line,
-                              dataLine,
-                              candidates);
-            double compS = 0.0;
-            auto itp = penMap.find(v);
-            if (itp != penMap.end())
-                compS = itp->second;
-
-            //double fS = bnLog + compS;
-            constexpr double LAMBDA = 6.0;
-            constexpr double EPS    = 1e-12; 
-            compS = std::max(compS, EPS);
-            double compLog = std::log(compS + EPS); 
-            double fS      = bnLog + LAMBDA * compLog;
-
-            scored.push_back({ v, bnLog, compS, fS });
+    // Sort by descending final score
+    std::sort(scored.begin(), scored.end(),
+              [](auto &a, auto &b){ return a.final > b.final; });
+
+    // Debug print
+    if (debug_) {
+        std::cout << "\n[Row " << line << "] attr='" << attr
+                  << "' candidate scores:\n";
+        for (auto &c : scored) {
+            std::cout
+              << "   " << am.candidates[c.idx]
+              << "  (BN="    << c.bn
+              << "  COMP="  << c.comp
+              << "  FINAL=" << c.final
+              << ")\n";
         }
+    }
 
-        // 4) Sort by descending final score
-        std::sort(scored.begin(), scored.end(),
-                  [](auto &a, auto &b){ return a.final > b.final; });
+    return scored.empty() ? -1 : int(scored.front().idx);
+}
 
-        // 5) Debug print
-        if (debug_) {
-            std::cout << "\n[Row " << line << "] attr='" << attr
-                      << "' candidate scores:\n";
-            for (auto &c : scored) {
-                std::cout
-                  << "   " << c.val
-                  << "  (BN="    << c.bn
-                  << "  COMP="  << c.comp
-                  << "  FINAL=" << c.final
-                  << ")\n";
+double Inference::cellSupport(RowSpan dataLine, int id, const vector<int>& nodeList)
+{
+    const auto& schema = dirtyData_.schema();
+    const string& attr = schema->attr_name(id);
+    const string& obs  = schema->dict(id).decode(dataLine[id]);
+
+    auto ita = occurrence1_.find(attr);
+    const unordered_map<string, unordered_map<string, int>>* byOther = nullptr;
+    if (ita != occurrence1_.end()) {
+        auto itv = ita->second.find(obs);
+        if (itv != ita->second.end())
+            byOther = &itv->second;
+    }
+
+    double sum = 0.0;
+    int count = 0;
+    for (int other : nodeList) {
+        if (other == id) continue;
+        const string& otherAttr = schema->attr_name(other);
+        const string& otherObs  = schema->dict(other).decode(dataLine[other]);
+
+        // joint count
+        int joint = 0;
+        if (byOther) {
+            auto itp = byOther->find(otherAttr);
+            if (itp != byOther->end()) {
+                auto itq = itp->second.find(otherObs);
+                if (itq != itp->second.end()) joint = itq->second;
             }
         }
 
-        // 6) Pick top
-        if (!scored.empty()) {
-            repaired[attr] = scored.front().val;
+        // marginal freq
+        int marg = 0;
+        auto itf = frequencyList_.find(otherAttr);
+        if (itf != frequencyList_.end()) {
+            auto itm = itf->second.find(otherObs);
+            if (itm != itf->second.end()) marg = itm->second;
         }
-    }
 
-    // // In repairLine
-    // auto isValid=[&](const std::string&val){…};
-
-    // for (auto &c: scored) {
-    //     if (!isValid(c.val)) continue;
+        sum += marg > 0 ? double(joint) / marg : 0.0;
+        ++count;
+    }
+    return count ? sum / count : 0.0;
+}
 
-    //     if (repaired[attr] != c.val) {
-    //         repairedCells_[{line, attr}] = {repaired[attr], c.val};
-    //     }
-    //     repaired[attr] = c.val;
-    //     break;
-    // }
+AnytimeResult Inference::repair_anytime(double budgetSeconds, double degradeAt)
+{
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    auto elapsed = [&]() {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    const vector<int>& nodes = nodes_;
+
+    const size_t n = dirtyData_.num_rows();
+    const size_t m = dirtyData_.num_attrs();
+
+    // The unrepaired data is already a usable answer
+    AnytimeResult result;
+    result.data = dirtyData_;
+    result.status.assign(n * m, CellStatus::Untouched);
+
+    struct Cell { size_t row; int id; };
+    vector<Cell> work;
+
+    // Phase 1 work: cells violating a constraint, which are certain errors
+    for (size_t i = 0; i < n; ++i)
+        for (int id : prun(dirtyData_.row(i), int(i), attrType_, nodes))
+            work.push_back({ i, id });
+
+    double fullSeconds = 0.0;
+    size_t fullCells = 0;
+    size_t next = 0;
+
+    // Visits work[next..end) until the deadline; returns false if time ran out
+    auto drain = [&]() {
+        for (; next < work.size(); ++next) {
+            double now = elapsed();
+            if (now >= budgetSeconds)
+                return false;
+
+            // Drop the compensative term once the projected cost of full
+            // scoring for the remaining cells no longer fits
+            size_t remaining = work.size() - next;
+            double perCell = fullCells ? fullSeconds / fullCells : 0.0;
+            bool degrade = now >= degradeAt * budgetSeconds ||
+                           now + remaining * perCell > budgetSeconds;
+
+            const Cell &cell = work[next];
+            auto cellStart = Clock::now();
+            int best = scoreCell(dirtyData_.row(cell.row), cell.id, int(cell.row), !degrade);
+            if (!degrade) {
+                fullSeconds += std::chrono::duration<double>(Clock::now() - cellStart).count();
+                ++fullCells;
+            }
 
+            if (best >= 0)
+                result.data.row_data(cell.row)[cell.id] = attrModels_[cell.id].candidateCodes[best];
+            result.status[cell.row * m + cell.id] =
+                degrade ? CellStatus::RepairedDegraded : CellStatus::Repaired;
+            ++(degrade ? result.degraded : result.full);
+        }
+        return true;
+    };
+
+    bool inTime = drain();
+
+    // Phase 2 work: cells with weak co-occurrence support, weakest first
+    if (inTime && tuplePrun_ > 0) {
+        vector<std::pair<double, Cell>> weak;
+        for (size_t i = 0; i < n && inTime; ++i) {
+            RowSpan row = dirtyData_.row(i);
+            for (int id : nodes) {
+                if (violations_.test(i, id)) continue;   // already in phase 1
+                double support = cellSupport(row, id, nodes);
+                if (support < tuplePrun_)
+                    weak.push_back({ support, { i, id } });
+            }
+            inTime = elapsed() < budgetSeconds;
+        }
+        std::stable_sort(weak.begin(), weak.end(),
+                         [](auto &a, auto &b) { return a.first < b.first; });
+        for (auto &w : weak)
+            work.push_back(w.second);
+        if (inTime)
+            inTime = drain();
+    }
 
-    return repaired;
+    for (size_t k = next; k < work.size(); ++k) {
+        result.status[work[k].row * m + work[k].id] = CellStatus::Skipped;
+        ++result.skipped;
+    }
+    result.completed = inTime && next == work.size();
+
+    std::cout << "Anytime repair: " << result.full << " full, "
+              << result.degraded << " degraded, "
+              << result.skipped << " skipped cells in "
+              << elapsed() << " s"
+              << (result.completed ? "" : " (budget exhausted)") << std::endl;
+    return result;
 }
 
-vector<string> Inference::prun(const Row& dataLine,
-                               int /*line*/,
-                               const AttrType& /*attrType*/,
-                               const vector<string>& nodeList)
+vector<int> Inference::prun(RowSpan dataLine,
+                            int line,
+                            const AttrType& /*attrType*/,
+                            const vector<int>& nodeList)
 {
-    vector<string> out;
-    for (auto &attr : nodeList) {
-        auto it = dataLine.find(attr);
-        if (it != dataLine.end() && it->second == "A Null Cell")
-            out.push_back(attr);
+    vector<int> out;
+    const bool known = line >= 0 && size_t(line) < violations_.num_rows() &&
+                       dataLine.codes == dirtyData_.row(line).codes;
+    for (int id : nodeList) {
+        if (known ? violations_.test(line, id) : detector_.violations(id, dataLine[id]) != 0)
+            out.push_back(id);
     }
     return out;
 }
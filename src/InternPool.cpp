@@ -0,0 +1,88 @@
+#include "../include/InternPool.h"
+#include "../include/MemoryFootprint.h"
+#include <functional>
+#include <iostream>
+#include <new>
+
+InternPool& InternPool::global()
+{
+    // Never destroyed, so values stay valid during static destruction
+    static InternPool* pool = new InternPool();
+    return *pool;
+}
+
+InternPool::InternPool() : shards_(new Shard[kShards])
+{
+    for (size_t s = 0; s < kShards; ++s)
+        for (int c = 0; c < kChunks; ++c)
+            shards_[s].chunks[c].store(nullptr, std::memory_order_relaxed);
+}
+
+InternPool::~InternPool()
+{
+    for (size_t s = 0; s < kShards; ++s)
+        for (int c = 0; c < kChunks; ++c)
+            delete[] shards_[s].chunks[c].load(std::memory_order_relaxed);
+}
+
+InternId InternPool::intern(std::string_view value)
+{
+    const size_t shard = std::hash<std::string_view>()(value) % kShards;
+    Shard& s = shards_[shard];
+    std::lock_guard<std::mutex> lock(s.mutex);
+    auto it = s.index.find(value);
+    if (it != s.index.end())
+        return it->second;
+
+    const size_t local = s.count;
+    if (local * kShards + shard >= kNoIntern) {
+        std::cerr << "InternPool: too many distinct values" << std::endl;
+        throw std::bad_alloc();
+    }
+    const int c = chunk_of(local);
+    std::string* chunk = s.chunks[c].load(std::memory_order_relaxed);
+    if (!chunk) {
+        chunk = new std::string[kFirstChunk << c];
+        s.chunks[c].store(chunk, std::memory_order_release);
+    }
+    std::string& stored = chunk[local - chunk_start(c)];
+    stored.assign(value.data(), value.size());
+    s.count++;
+
+    const InternId id = InternId(local * kShards + shard);
+    s.index.emplace(std::string_view(stored), id);
+    return id;
+}
+
+InternId InternPool::find(std::string_view value) const
+{
+    const Shard& s = shards_[std::hash<std::string_view>()(value) % kShards];
+    std::lock_guard<std::mutex> lock(s.mutex);
+    auto it = s.index.find(value);
+    return it == s.index.end() ? kNoIntern : it->second;
+}
+
+size_t InternPool::size() const
+{
+    size_t total = 0;
+    for (size_t s = 0; s < kShards; ++s) {
+        std::lock_guard<std::mutex> lock(shards_[s].mutex);
+        total += shards_[s].count;
+    }
+    return total;
+}
+
+size_t InternPool::memory_footprint() const
+{
+    size_t bytes = 0;
+    for (size_t s = 0; s < kShards; ++s) {
+        const Shard& shard = shards_[s];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        bytes += footprint(shard.index);
+        for (int c = 0; c < kChunks && chunk_start(c) < shard.count; ++c)
+            bytes += (kFirstChunk << c) * sizeof(std::string);
+        for (size_t k = 0; k < shard.count; ++k)
+            bytes += footprint(str(InternId(k * kShards + s)));
+    }
+    return bytes;
+}
@@ -0,0 +1,267 @@
+#include "../include/JsonReader.h"
+#include <cstdlib>
+
+static const size_t kBlockSize = 64 * 1024;
+
+JsonReader::JsonReader(std::istream& in) : in(in), buffer(kBlockSize) {}
+
+int JsonReader::peek()
+{
+    if (pos == end) {
+        in.read(buffer.data(), buffer.size());
+        end = size_t(in.gcount());
+        pos = 0;
+        if (end == 0)
+            return -1;
+    }
+    return (unsigned char)buffer[pos];
+}
+
+int JsonReader::get()
+{
+    int c = peek();
+    if (c < 0)
+        return c;
+    ++pos;
+    if (c == '\n') {
+        ++line;
+        column = 1;
+    } else {
+        ++column;
+    }
+    return c;
+}
+
+void JsonReader::skip_space()
+{
+    for (int c = peek(); c == ' ' || c == '\t' || c == '\n' || c == '\r'; c = peek())
+        get();
+}
+
+bool JsonReader::fail(const std::string& what)
+{
+    if (message.empty())
+        message = "line " + std::to_string(line) + ", column " + std::to_string(column) + ": " + what;
+    return false;
+}
+
+bool JsonReader::parse(JsonHandler& handler)
+{
+    message.clear();
+    skip_space();
+    if (!parse_value(handler, 0))
+        return false;
+    skip_space();
+    if (peek() >= 0)
+        return fail("unexpected data after the document");
+    return true;
+}
+
+bool JsonReader::parse_value(JsonHandler& handler, int depth)
+{
+    if (depth > kMaxDepth)
+        return fail("nested too deeply");
+
+    int c = peek();
+    switch (c) {
+    case '{': {
+        get();
+        handler.start_object();
+        skip_space();
+        if (peek() == '}') {
+            get();
+            handler.end_object();
+            return true;
+        }
+        for (;;) {
+            skip_space();
+            if (peek() != '"')
+                return fail("expected a key");
+            get();
+            if (!parse_string(scratch))
+                return false;
+            handler.key(scratch);
+            skip_space();
+            if (get() != ':')
+                return fail("expected ':'");
+            skip_space();
+            if (!parse_value(handler, depth + 1))
+                return false;
+            skip_space();
+            c = get();
+            if (c == '}')
+                break;
+            if (c != ',')
+                return fail("expected ',' or '}'");
+        }
+        handler.end_object();
+        return true;
+    }
+    case '[': {
+        get();
+        handler.start_array();
+        skip_space();
+        if (peek() == ']') {
+            get();
+            handler.end_array();
+            return true;
+        }
+        for (;;) {
+            skip_space();
+            if (!parse_value(handler, depth + 1))
+                return false;
+            skip_space();
+            c = get();
+            if (c == ']')
+                break;
+            if (c != ',')
+                return fail("expected ',' or ']'");
+        }
+        handler.end_array();
+        return true;
+    }
+    case '"':
+        get();
+        if (!parse_string(scratch))
+            return false;
+        handler.string_value(scratch);
+        return true;
+    case 't':
+        if (!parse_literal("true"))
+            return false;
+        handler.boolean(true);
+        return true;
+    case 'f':
+        if (!parse_literal("false"))
+            return false;
+        handler.boolean(false);
+        return true;
+    case 'n':
+        if (!parse_literal("null"))
+            return false;
+        handler.null();
+        return true;
+    default:
+        if (c == '-' || (c >= '0' && c <= '9'))
+            return parse_number(handler);
+        return fail(c < 0 ? "unexpected end of input" : "unexpected character");
+    }
+}
+
+bool JsonReader::parse_literal(const char* word)
+{
+    for (const char* p = word; *p; ++p)
+        if (get() != *p)
+            return fail(std::string("expected '") + word + "'");
+    return true;
+}
+
+// Appends code point cp to out as UTF-8
+static void append_utf8(std::string& out, unsigned cp)
+{
+    if (cp < 0x80) {
+        out += char(cp);
+    } else if (cp < 0x800) {
+        out += char(0xC0 | (cp >> 6));
+        out += char(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += char(0xE0 | (cp >> 12));
+        out += char(0x80 | ((cp >> 6) & 0x3F));
+        out += char(0x80 | (cp & 0x3F));
+    } else {
+        out += char(0xF0 | (cp >> 18));
+        out += char(0x80 | ((cp >> 12) & 0x3F));
+        out += char(0x80 | ((cp >> 6) & 0x3F));
+        out += char(0x80 | (cp & 0x3F));
+    }
+}
+
+bool JsonReader::parse_string(std::string& out)
+{
+    // The opening quote has been read
+    out.clear();
+    auto hex4 = [&](unsigned& v) {
+        v = 0;
+        for (int k = 0; k < 4; ++k) {
+            int h = get();
+            v <<= 4;
+            if (h >= '0' && h <= '9') v |= unsigned(h - '0');
+            else if (h >= 'a' && h <= 'f') v |= unsigned(h - 'a' + 10);
+            else if (h >= 'A' && h <= 'F') v |= unsigned(h - 'A' + 10);
+            else return fail("bad \\u escape");
+        }
+        return true;
+    };
+
+    for (;;) {
+        int c = get();
+        if (c < 0)
+            return fail("unterminated string");
+        if (c == '"')
+            return true;
+        if (c < 0x20)
+            return fail("control character in string");
+        if (c != '\\') {
+            out += char(c);
+            continue;
+        }
+        c = get();
+        switch (c) {
+        case '"':  out += '"'; break;
+        case '\\': out += '\\'; break;
+        case '/':  out += '/'; break;
+        case 'b':  out += '\b'; break;
+        case 'f':  out += '\f'; break;
+        case 'n':  out += '\n'; break;
+        case 'r':  out += '\r'; break;
+        case 't':  out += '\t'; break;
+        case 'u': {
+            unsigned cp;
+            if (!hex4(cp))
+                return false;
+            if (cp >= 0xD800 && cp < 0xDC00) {
+                unsigned low;
+                if (get() != '\\' || get() != 'u' || !hex4(low) || low < 0xDC00 || low >= 0xE000)
+                    return fail("bad surrogate pair");
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+            }
+            append_utf8(out, cp);
+            break;
+        }
+        default:
+            return fail("bad escape");
+        }
+    }
+}
+
+bool JsonReader::parse_number(JsonHandler& handler)
+{
+    std::string text;
+    auto digits = [&]() {
+        size_t start = text.size();
+        while (peek() >= '0' && peek() <= '9')
+            text += char(get());
+        return text.size() > start;
+    };
+
+    if (peek() == '-')
+        text += char(get());
+    if (peek() == '0')
+        text += char(get());
+    else if (!digits())
+        return fail("bad number");
+    if (peek() == '.') {
+        text += char(get());
+        if (!digits())
+            return fail("bad number");
+    }
+    if (peek() == 'e' || peek() == 'E') {
+        text += char(get());
+        if (peek() == '+' || peek() == '-')
+            text += char(get());
+        if (!digits())
+            return fail("bad number");
+    }
+    handler.number(text, std::strtod(text.c_str(), nullptr));
+    return true;
+}
@@ -0,0 +1,330 @@
+#include "../include/ModelFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char kMagic[8] = {'B', 'C', 'L', 'N', 'M', 'D', 'L', '1'};
+static const uint32_t kVersion = 1;
+
+// Header: magic, version, num_attrs, num_edges, pad, then uint64 offsets of
+// strings, attrs, values, edges, families and the file size
+static const size_t kHeaderSize = 8 + 4 * 4 + 6 * 8;
+static const size_t kAttrWords = 6;     // name off, name len, first, count, family off (2)
+static const size_t kValueWords = 3;    // off, len, count
+
+namespace {
+
+struct Buffer {
+    std::string bytes;
+
+    void u32(uint32_t v) { bytes.append(reinterpret_cast<const char*>(&v), 4); }
+    void u64(uint64_t v) { bytes.append(reinterpret_cast<const char*>(&v), 8); }
+    void pad4() { bytes.append((4 - bytes.size() % 4) % 4, '\0'); }
+};
+
+}  // namespace
+
+bool save_model_file(const std::string& path,
+                     const std::vector<std::string>& attrs,
+                     const CodedColumns& cols,
+                     const std::vector<Edge>& edges)
+{
+    const size_t m = attrs.size();
+    const size_t n = cols.num_rows;
+    if (cols.num_attrs() != m) {
+        std::cerr << "Model columns do not match attributes" << std::endl;
+        return false;
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> edge_ids;
+    std::vector<std::vector<int>> parents(m);
+    for (const auto& e : edges) {
+        auto from = std::find(attrs.begin(), attrs.end(), e.from);
+        auto to = std::find(attrs.begin(), attrs.end(), e.to);
+        if (from == attrs.end() || to == attrs.end())
+            continue;
+        edge_ids.emplace_back(uint32_t(from - attrs.begin()), uint32_t(to - attrs.begin()));
+        parents[to - attrs.begin()].push_back(int(from - attrs.begin()));
+    }
+    std::sort(edge_ids.begin(), edge_ids.end());
+    for (auto& p : parents)
+        std::sort(p.begin(), p.end());
+
+    // Strings, attribute table and value table
+    Buffer strings, attr_table, value_table;
+    uint32_t next_value = 0;
+    std::vector<size_t> family_slot(m);
+    for (size_t a = 0; a < m; ++a) {
+        attr_table.u32(uint32_t(strings.bytes.size()));
+        attr_table.u32(uint32_t(attrs[a].size()));
+        strings.bytes += attrs[a];
+        attr_table.u32(next_value);
+        attr_table.u32(uint32_t(cols.cardinality(a)));
+        family_slot[a] = attr_table.bytes.size();
+        attr_table.u64(0);   // patched below
+        for (uint32_t c = 0; c < cols.cardinality(a); ++c) {
+            value_table.u32(uint32_t(strings.bytes.size()));
+            value_table.u32(uint32_t(cols.values[a][c].size()));
+            value_table.u32(uint32_t(cols.counts[a][c]));
+            strings.bytes += cols.values[a][c];
+        }
+        next_value += uint32_t(cols.cardinality(a));
+    }
+    strings.pad4();
+
+    Buffer edge_table;
+    for (const auto& e : edge_ids) {
+        edge_table.u32(e.first);
+        edge_table.u32(e.second);
+    }
+
+    // Family counts, configurations in parent-code order
+    Buffer families;
+    std::vector<uint64_t> family_offset(m);
+    for (size_t a = 0; a < m; ++a) {
+        family_offset[a] = families.bytes.size();
+        const auto& ps = parents[a];
+        std::map<std::vector<uint32_t>, std::map<uint32_t, uint32_t>> counts;
+        std::vector<uint32_t> key(ps.size());
+        for (size_t r = 0; r < n; ++r) {
+            for (size_t k = 0; k < ps.size(); ++k)
+                key[k] = cols.codes[ps[k]][r];
+            counts[key][cols.codes[a][r]]++;
+        }
+
+        families.u32(uint32_t(ps.size()));
+        for (int p : ps)
+            families.u32(uint32_t(p));
+        families.u32(uint32_t(counts.size()));
+        for (const auto& cfg : counts) {
+            uint32_t n_j = 0;
+            for (const auto& kv : cfg.second)
+                n_j += kv.second;
+            for (uint32_t code : cfg.first)
+                families.u32(code);
+            families.u32(n_j);
+            families.u32(uint32_t(cfg.second.size()));
+            for (const auto& kv : cfg.second) {
+                families.u32(kv.first);
+                families.u32(kv.second);
+            }
+        }
+    }
+
+    const uint64_t strings_off = kHeaderSize;
+    const uint64_t attrs_off = strings_off + strings.bytes.size();
+    const uint64_t values_off = attrs_off + attr_table.bytes.size();
+    const uint64_t edges_off = values_off + value_table.bytes.size();
+    const uint64_t families_off = edges_off + edge_table.bytes.size();
+    const uint64_t total = families_off + families.bytes.size();
+
+    for (size_t a = 0; a < m; ++a) {
+        uint64_t off = families_off + family_offset[a];
+        std::memcpy(&attr_table.bytes[family_slot[a]], &off, 8);
+    }
+
+    Buffer header;
+    header.bytes.append(kMagic, 8);
+    header.u32(kVersion);
+    header.u32(uint32_t(m));
+    header.u32(uint32_t(edge_ids.size()));
+    header.u32(0);
+    for (uint64_t off : {strings_off, attrs_off, values_off, edges_off, families_off, total})
+        header.u64(off);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Cannot write model file: " << path << std::endl;
+        return false;
+    }
+    for (const Buffer* b : {&header, &strings, &attr_table, &value_table, &edge_table, &families})
+        out.write(b->bytes.data(), b->bytes.size());
+    return bool(out);
+}
+
+//-------------------------------- ModelFile ----------------------------------
+
+ModelFile::~ModelFile()
+{
+    close();
+}
+
+bool ModelFile::open(const std::string& path)
+{
+    close();
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Cannot open model file: " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || size_t(st.st_size) < kHeaderSize) {
+        std::cerr << "Not a model file: " << path << std::endl;
+        close();
+        return false;
+    }
+    void* p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+        std::cerr << "Cannot map model file: " << path << std::endl;
+        close();
+        return false;
+    }
+    base = static_cast<const char*>(p);
+    length = st.st_size;
+
+    uint64_t total;
+    std::memcpy(&total, base + kHeaderSize - 8, 8);
+    if (std::memcmp(base, kMagic, 8) != 0 || *u32(8) != kVersion || total != length) {
+        std::cerr << "Not a model file (or wrong version): " << path << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void ModelFile::close()
+{
+    if (base)
+        ::munmap(const_cast<char*>(base), length);
+    if (fd >= 0)
+        ::close(fd);
+    base = nullptr;
+    length = 0;
+    fd = -1;
+}
+
+const uint32_t* ModelFile::u32(uint64_t offset) const
+{
+    return reinterpret_cast<const uint32_t*>(base + offset);
+}
+
+std::string_view ModelFile::str(uint32_t offset, uint32_t len) const
+{
+    uint64_t strings_off;
+    std::memcpy(&strings_off, base + 24, 8);
+    return std::string_view(base + strings_off + offset, len);
+}
+
+// Section offsets, in header order
+static uint64_t section(const char* base, int k)
+{
+    uint64_t off;
+    std::memcpy(&off, base + 24 + 8 * k, 8);
+    return off;
+}
+
+size_t ModelFile::num_attrs() const
+{
+    return *u32(12);
+}
+
+std::string_view ModelFile::attr_name(size_t attr) const
+{
+    const uint32_t* row = u32(section(base, 1) + attr * kAttrWords * 4);
+    return str(row[0], row[1]);
+}
+
+int ModelFile::attr_id(std::string_view name) const
+{
+    for (size_t a = 0; a < num_attrs(); ++a)
+        if (attr_name(a) == name)
+            return int(a);
+    return -1;
+}
+
+size_t ModelFile::dict_size(size_t attr) const
+{
+    return u32(section(base, 1) + attr * kAttrWords * 4)[3];
+}
+
+std::string_view ModelFile::value(size_t attr, uint32_t code) const
+{
+    uint32_t first = u32(section(base, 1) + attr * kAttrWords * 4)[2];
+    const uint32_t* v = u32(section(base, 2) + (uint64_t(first) + code) * kValueWords * 4);
+    return str(v[0], v[1]);
+}
+
+uint32_t ModelFile::value_count(size_t attr, uint32_t code) const
+{
+    uint32_t first = u32(section(base, 1) + attr * kAttrWords * 4)[2];
+    return u32(section(base, 2) + (uint64_t(first) + code) * kValueWords * 4)[2];
+}
+
+uint32_t ModelFile::lookup(size_t attr, std::string_view v) const
+{
+    // Dictionaries are sorted, so this is a binary search
+    uint32_t lo = 0, hi = uint32_t(dict_size(attr));
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (value(attr, mid) < v)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return (lo < dict_size(attr) && value(attr, lo) == v) ? lo : UINT32_MAX;
+}
+
+std::vector<Edge> ModelFile::edges() const
+{
+    std::vector<Edge> out;
+    const uint32_t* e = u32(section(base, 3));
+    for (uint32_t k = 0; k < *u32(16); ++k)
+        out.emplace_back(std::string(attr_name(e[2 * k])), std::string(attr_name(e[2 * k + 1])));
+    return out;
+}
+
+std::vector<int> ModelFile::parents(size_t attr) const
+{
+    uint64_t off;
+    std::memcpy(&off, base + section(base, 1) + attr * kAttrWords * 4 + 16, 8);
+    const uint32_t* f = u32(off);
+    return std::vector<int>(f + 1, f + 1 + f[0]);
+}
+
+double ModelFile::cpt(size_t attr, const std::vector<uint32_t>& parent_codes, uint32_t code) const
+{
+    uint64_t off;
+    std::memcpy(&off, base + section(base, 1) + attr * kAttrWords * 4 + 16, 8);
+    const uint32_t* f = u32(off);
+    const uint32_t np = f[0];
+    if (parent_codes.size() != np)
+        return 0.0;
+    const uint32_t* p = f + 1 + np;
+    const uint32_t configs = *p++;
+
+    // Configurations are variable-length records, so they are walked in
+    // order; the walk stops early once past the wanted codes
+    for (uint32_t c = 0; c < configs; ++c) {
+        int cmp = 0;
+        for (uint32_t k = 0; k < np && cmp == 0; ++k)
+            cmp = p[k] < parent_codes[k] ? -1 : (p[k] > parent_codes[k] ? 1 : 0);
+        const uint32_t n_j = p[np], nnz = p[np + 1];
+        const uint32_t* cells = p + np + 2;
+        if (cmp > 0)
+            break;
+        if (cmp == 0) {
+            for (uint32_t k = 0; k < nnz; ++k)
+                if (cells[2 * k] == code)
+                    return n_j ? double(cells[2 * k + 1]) / n_j : 0.0;
+            return 0.0;
+        }
+        p = cells + 2 * nnz;
+    }
+    return 0.0;
+}
+
+BNGraph ModelFile::graph() const
+{
+    BNGraph g;
+    for (size_t a = 0; a < num_attrs(); ++a)
+        g.adjacency_list[std::string(attr_name(a))];
+    for (const auto& e : edges())
+        g.adjacency_list[e.from].insert(e.to);
+    return g;
+}
@@ -0,0 +1,23 @@
+#include "../include/ModelSnapshot.h"
+#include "../include/Compensative.h"
+#include "../include/MemoryFootprint.h"
+
+ModelSnapshotPtr ModelSnapshot::publish(Compensative& stats, BNResult bn)
+{
+    auto model = std::make_shared<ModelSnapshot>();
+    stats.move_statistics_to(*model);
+    model->full_graph = std::move(bn.full_graph);
+    model->partition_graphs = std::move(bn.partition_graphs);
+    return model;
+}
+
+std::map<std::string, size_t> ModelSnapshot::memory_footprint() const
+{
+    size_t graphs = footprint(full_graph.adjacency_list);
+    for (const auto& part : partition_graphs)
+        graphs += footprint(part.first) + footprint(part.second.adjacency_list);
+    return {{"frequency", footprint(frequency)},
+            {"occurrence", footprint(occurrence)},
+            {"occurrence1", footprint(occurrence1)},
+            {"graphs", graphs}};
+}
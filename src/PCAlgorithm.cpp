@@ -0,0 +1,410 @@
+#include "../include/PCAlgorithm.h"
+#include "../include/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+// Upper regularized incomplete gamma Q(a, x), i.e. the chi-square survival
+// function at 2x with 2a degrees of freedom
+static double gamma_q(double a, double x)
+{
+    if (x <= 0.0)
+        return 1.0;
+    const double log_front = -x + a * std::log(x) - std::lgamma(a);
+    if (x < a + 1.0) {
+        double ap = a, del = 1.0 / a, sum = del;
+        for (int k = 0; k < 1000; ++k) {
+            ap += 1.0;
+            del *= x / ap;
+            sum += del;
+            if (std::fabs(del) < std::fabs(sum) * 1e-14)
+                break;
+        }
+        return std::max(0.0, 1.0 - sum * std::exp(log_front));
+    }
+    const double tiny = 1e-300;
+    double b = x + 1.0 - a, c = 1.0 / tiny, d = 1.0 / b, h = d;
+    for (int k = 1; k < 1000; ++k) {
+        double an = -k * (k - a);
+        b += 2.0;
+        d = an * d + b;
+        if (std::fabs(d) < tiny) d = tiny;
+        c = b + an / c;
+        if (std::fabs(c) < tiny) c = tiny;
+        d = 1.0 / d;
+        double del = d * c;
+        h *= del;
+        if (std::fabs(del - 1.0) < 1e-14)
+            break;
+    }
+    return std::exp(log_front) * h;
+}
+
+//------------------------------ CITestEngine ---------------------------------
+
+CITestEngine::CITestEngine(const CodedColumns& cols, Statistic statistic)
+    : cols(cols), statistic(statistic) {}
+
+double CITestEngine::p_value(int x, int y, const std::vector<int>& z)
+{
+    if (x > y)
+        std::swap(x, y);
+    std::vector<int> key{x, y};
+    key.insert(key.end(), z.begin(), z.end());
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tests++;
+        auto it = results.find(key);
+        if (it != results.end()) {
+            hits++;
+            return it->second;
+        }
+    }
+
+    double p = compute(x, y, *strata(z));
+    std::lock_guard<std::mutex> lock(mutex);
+    results.emplace(std::move(key), p);
+    return p;
+}
+
+void CITestEngine::clear_strata()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    strata_cache.clear();
+    cached_rows = 0;
+}
+
+std::shared_ptr<const CITestEngine::Strata> CITestEngine::strata(const std::vector<int>& z)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = strata_cache.find(z);
+        if (it != strata_cache.end())
+            return it->second;
+    }
+
+    // Number the observed configurations of z densely, one column at a time
+    const size_t n = cols.num_rows;
+    auto s = std::make_shared<Strata>();
+    s->id.assign(n, 0);
+    size_t count = 1;
+    for (int a : z) {
+        const auto& codes = cols.codes[a];
+        std::unordered_map<uint64_t, uint32_t> ids;
+        ids.reserve(std::min(n, count * cols.cardinality(a)));
+        for (size_t r = 0; r < n; ++r) {
+            uint64_t k = (uint64_t(s->id[r]) << 32) | codes[r];
+            s->id[r] = ids.emplace(k, uint32_t(ids.size())).first->second;
+        }
+        count = ids.size();
+    }
+    s->size.assign(count, 0);
+    for (size_t r = 0; r < n; ++r)
+        s->size[s->id[r]]++;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (cached_rows + n <= kMaxCachedRows) {
+        auto it = strata_cache.emplace(z, s).first;
+        if (it->second == s)
+            cached_rows += n;
+        return it->second;
+    }
+    return s;
+}
+
+double CITestEngine::compute(int x, int y, const Strata& s) const
+{
+    const size_t n = cols.num_rows;
+    const auto& cx = cols.codes[x];
+    const auto& cy = cols.codes[y];
+    if (n == 0)
+        return 1.0;
+
+    // Within-stratum margins of x and y get dense ids; the joint is keyed
+    // by the pair of margin ids
+    std::unordered_map<uint64_t, uint32_t> zx_id, zy_id;
+    std::vector<int> n_zx, n_zy;
+    std::vector<uint32_t> zx_stratum;
+    std::unordered_map<uint64_t, int> joint;
+    for (size_t r = 0; r < n; ++r) {
+        uint64_t z = s.id[r];
+        auto ix = zx_id.emplace((z << 32) | cx[r], uint32_t(n_zx.size())).first->second;
+        if (ix == n_zx.size()) {
+            n_zx.push_back(0);
+            zx_stratum.push_back(uint32_t(z));
+        }
+        n_zx[ix]++;
+        auto iy = zy_id.emplace((z << 32) | cy[r], uint32_t(n_zy.size())).first->second;
+        if (iy == n_zy.size())
+            n_zy.push_back(0);
+        n_zy[iy]++;
+        joint[(uint64_t(ix) << 32) | iy]++;
+    }
+
+    // Degrees of freedom from the levels observed in each stratum
+    std::vector<int> levels_x(s.size.size(), 0), levels_y(s.size.size(), 0);
+    for (const auto& kv : zx_id)
+        levels_x[kv.first >> 32]++;
+    for (const auto& kv : zy_id)
+        levels_y[kv.first >> 32]++;
+    double df = 0.0;
+    for (size_t z = 0; z < s.size.size(); ++z)
+        df += double(std::max(levels_x[z] - 1, 0)) * std::max(levels_y[z] - 1, 0);
+    if (df <= 0.0)
+        return 1.0;
+
+    double stat = 0.0;
+    for (const auto& kv : joint) {
+        uint32_t ix = uint32_t(kv.first >> 32), iy = uint32_t(kv.first);
+        double o = kv.second;
+        double nz = s.size[zx_stratum[ix]];
+        double ratio = o * nz / (double(n_zx[ix]) * n_zy[iy]);
+        if (statistic == Statistic::G2)
+            stat += 2.0 * o * std::log(ratio);
+        else
+            stat += o * ratio;
+    }
+    // Pearson: sum (O - E)^2 / E = sum O^2 / E - n over the non-zero cells
+    if (statistic == Statistic::Chi2)
+        stat -= double(n);
+
+    return gamma_q(df / 2.0, std::max(stat, 0.0) / 2.0);
+}
+
+//------------------------------- PCAlgorithm ---------------------------------
+
+PCAlgorithm::PCAlgorithm(const CodedColumns& cols, const StructureOptions& options, int num_worker)
+    : cols(cols), options(options),
+      engine(cols, options.ci_test == "chi2" ? CITestEngine::Statistic::Chi2 : CITestEngine::Statistic::G2),
+      pool(new ThreadPool(num_worker > 0 ? num_worker : 1)),
+      m(int(cols.num_attrs())) {}
+
+PCAlgorithm::~PCAlgorithm() = default;
+
+std::vector<std::pair<int, int>> PCAlgorithm::run(const std::vector<std::pair<int, int>>& required_edges)
+{
+    adj.assign(size_t(m) * m, 1);
+    for (int v = 0; v < m; ++v)
+        adj[size_t(v) * m + v] = 0;
+    dir.assign(size_t(m) * m, 0);
+    required.assign(size_t(m) * m, 0);
+    sepset.clear();
+
+    for (const auto& e : required_edges) {
+        if (e.first == e.second || required[size_t(e.second) * m + e.first])
+            continue;
+        required[size_t(e.first) * m + e.second] = 1;
+    }
+
+    skeleton();
+    orient();
+
+    std::vector<std::pair<int, int>> result;
+    for (int u = 0; u < m; ++u)
+        for (int v = 0; v < m; ++v)
+            if (directed(u, v))
+                result.emplace_back(u, v);
+    return result;
+}
+
+void PCAlgorithm::skeleton()
+{
+    for (int level = 0; level <= options.max_cond_size; ++level) {
+        // Removable edges; required ones are never tested
+        std::vector<std::pair<int, int>> edges;
+        for (int u = 0; u < m; ++u) {
+            for (int v = u + 1; v < m; ++v) {
+                if (!adjacent(u, v))
+                    continue;
+                if (required[size_t(u) * m + v] || required[size_t(v) * m + u])
+                    continue;
+                edges.emplace_back(u, v);
+            }
+        }
+
+        // PC-stable: every test of this level sees the adjacencies as they
+        // were when the level started
+        std::vector<std::vector<int>> neighbours(m);
+        for (int u = 0; u < m; ++u)
+            for (int v = 0; v < m; ++v)
+                if (adjacent(u, v))
+                    neighbours[u].push_back(v);
+
+        std::vector<char> removed(edges.size(), 0);
+        std::vector<std::vector<int>> found(edges.size());
+        pool->run(edges.size(), [&](size_t k) {
+            const int u = edges[k].first, v = edges[k].second;
+            for (int side = 0; side < 2; ++side) {
+                int a = side ? v : u, b = side ? u : v;
+                std::vector<int> cand;
+                for (int w : neighbours[a])
+                    if (w != b)
+                        cand.push_back(w);
+                if ((int)cand.size() < level)
+                    continue;
+
+                // Subsets of size level in lexicographic order
+                std::vector<int> pick(level);
+                for (int i = 0; i < level; ++i)
+                    pick[i] = i;
+                while (true) {
+                    std::vector<int> z(level);
+                    for (int i = 0; i < level; ++i)
+                        z[i] = cand[pick[i]];
+                    std::sort(z.begin(), z.end());
+                    if (engine.p_value(u, v, z) > options.alpha) {
+                        removed[k] = 1;
+                        found[k] = z;
+                        return;
+                    }
+                    int i = level - 1;
+                    while (i >= 0 && pick[i] == (int)cand.size() - level + i)
+                        --i;
+                    if (i < 0)
+                        break;
+                    pick[i]++;
+                    for (int j = i + 1; j < level; ++j)
+                        pick[j] = pick[j - 1] + 1;
+                }
+            }
+        });
+
+        for (size_t k = 0; k < edges.size(); ++k) {
+            if (!removed[k])
+                continue;
+            int u = edges[k].first, v = edges[k].second;
+            adj[size_t(u) * m + v] = adj[size_t(v) * m + u] = 0;
+            sepset[{u, v}] = found[k];
+        }
+        engine.clear_strata();
+
+        // Done once no node has more than level + 1 neighbours, i.e. no
+        // edge has a conditioning set of the next size
+        bool deeper = false;
+        for (int u = 0; u < m && !deeper; ++u) {
+            int degree = 0;
+            for (int v = 0; v < m; ++v)
+                degree += adjacent(u, v);
+            deeper = degree - 1 > level;
+        }
+        if (!deeper)
+            break;
+    }
+}
+
+void PCAlgorithm::orient()
+{
+    auto set_dir = [&](int u, int v) {
+        if (directed(v, u))
+            return false;
+        dir[size_t(u) * m + v] = 1;
+        return true;
+    };
+
+    // Required edges first; nothing below overrides them
+    for (int u = 0; u < m; ++u)
+        for (int v = 0; v < m; ++v)
+            if (required[size_t(u) * m + v]) {
+                adj[size_t(u) * m + v] = adj[size_t(v) * m + u] = 1;
+                dir[size_t(u) * m + v] = 1;
+            }
+
+    // v-structures: x - z - y with x, y apart and z not separating them
+    for (int z = 0; z < m; ++z) {
+        for (int x = 0; x < m; ++x) {
+            if (x == z || !adjacent(x, z))
+                continue;
+            for (int y = x + 1; y < m; ++y) {
+                if (y == z || !adjacent(y, z) || adjacent(x, y))
+                    continue;
+                auto it = sepset.find({x, y});
+                if (it != sepset.end() &&
+                    std::find(it->second.begin(), it->second.end(), z) != it->second.end())
+                    continue;
+                if (undirected(x, z)) set_dir(x, z);
+                if (undirected(y, z)) set_dir(y, z);
+            }
+        }
+    }
+
+    // Meek's rules R1-R3 until nothing changes
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int a = 0; a < m; ++a) {
+            for (int b = 0; b < m; ++b) {
+                if (a == b || !undirected(a, b))
+                    continue;
+                bool orient_ab = false;
+                for (int c = 0; c < m && !orient_ab; ++c) {
+                    if (c == a || c == b)
+                        continue;
+                    // R1: c -> a - b, c and b apart
+                    if (directed(c, a) && !adjacent(c, b))
+                        orient_ab = true;
+                    // R2: a -> c -> b
+                    else if (directed(a, c) && directed(c, b))
+                        orient_ab = true;
+                }
+                // R3: a - c -> b and a - d -> b with c, d apart
+                for (int c = 0; c < m && !orient_ab; ++c) {
+                    if (c == a || c == b || !undirected(a, c) || !directed(c, b))
+                        continue;
+                    for (int d = c + 1; d < m; ++d) {
+                        if (d == a || d == b || !undirected(a, d) || !directed(d, b) || adjacent(c, d))
+                            continue;
+                        orient_ab = true;
+                        break;
+                    }
+                }
+                if (orient_ab && set_dir(a, b))
+                    changed = true;
+            }
+        }
+    }
+
+    // Conflicting orientations on noisy data can leave cycles; rebuild the
+    // DAG edge by edge (required edges first) and reverse any edge that
+    // would close one. Undirected edges go from the lower index.
+    std::vector<std::pair<int, int>> order;
+    for (int pass = 0; pass < 3; ++pass)
+        for (int u = 0; u < m; ++u)
+            for (int v = 0; v < m; ++v) {
+                if (!adjacent(u, v))
+                    continue;
+                bool req = required[size_t(u) * m + v];
+                bool d = directed(u, v);
+                if ((pass == 0 && req) || (pass == 1 && d && !req) ||
+                    (pass == 2 && u < v && !d && !directed(v, u)))
+                    order.emplace_back(u, v);
+            }
+
+    std::fill(dir.begin(), dir.end(), 0);
+    for (const auto& e : order) {
+        int u = e.first, v = e.second;
+        if (directed(u, v) || directed(v, u))
+            continue;
+        if (reaches(v, u))
+            std::swap(u, v);
+        dir[size_t(u) * m + v] = 1;
+    }
+}
+
+bool PCAlgorithm::reaches(int from, int to) const
+{
+    std::vector<char> seen(m, 0);
+    std::vector<int> stack{from};
+    seen[from] = 1;
+    while (!stack.empty()) {
+        int x = stack.back();
+        stack.pop_back();
+        if (x == to)
+            return true;
+        for (int y = 0; y < m; ++y)
+            if (directed(x, y) && !seen[y]) {
+                seen[y] = 1;
+                stack.push_back(y);
+            }
+    }
+    return false;
+}
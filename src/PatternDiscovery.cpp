@@ -0,0 +1,117 @@
+#include "../include/PatternDiscovery.h"
+#include "../include/ColumnProfile.h"
+#include "../dataset.h"
+#include <regex>
+
+namespace {
+
+struct Candidate {
+    std::string pattern;
+    std::regex re;
+};
+
+// Tried in order; the first one matching every value wins
+const std::vector<Candidate>& candidates()
+{
+    static const std::vector<Candidate> list = {
+        {"\\d+(\\.\\d+)?%?", std::regex("^\\d+(\\.\\d+)?%?$")},            // Numeric (integer or float) with optional %
+        {"[A-Za-z]+", std::regex("^[A-Za-z]+$")},                          // Alphabetical only
+        {"[A-Za-z0-9]+", std::regex("^[A-Za-z0-9]+$")},                    // Alphanumeric
+        {"\\d{4}-\\d{2}-\\d{2}", std::regex("^\\d{4}-\\d{2}-\\d{2}$")},    // Date in YYYY-MM-DD
+        {"\\w+@\\w+\\.\\w+", std::regex("^\\w+@\\w+\\.\\w+$")},            // Email (simple)
+        {"[A-Za-z\\.\\s]+", std::regex("^[A-Za-z\\.\\s]+$")}               // Allow letters, dots, and spaces
+    };
+    return list;
+}
+
+enum CharClass { Digit, Letter, Other };
+
+inline CharClass char_class(unsigned char c)
+{
+    if (c >= '0' && c <= '9')
+        return Digit;
+    if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'))
+        return Letter;
+    return Other;
+}
+
+}  // namespace
+
+std::string value_shape(std::string_view value)
+{
+    std::string shape;
+    size_t i = 0;
+    while (i < value.size()) {
+        CharClass cls = char_class(value[i]);
+        if (cls == Other) {
+            shape += value[i++];
+            continue;
+        }
+        size_t run = i;
+        while (i < value.size() && char_class(value[i]) == cls)
+            ++i;
+        shape += cls == Digit ? 'D' : 'A';
+        shape += std::to_string(i - run);
+    }
+    return shape;
+}
+
+void ShapeHistogram::add(std::string_view value)
+{
+    // Whitespace-only values are kept untrimmed, as before
+    size_t start = value.find_first_not_of(" \t");
+    size_t end = value.find_last_not_of(" \t");
+    if (start != std::string_view::npos)
+        value = value.substr(start, end - start + 1);
+    if (value.empty())
+        return;
+
+    auto& entry = shapes[value_shape(value)];
+    if (entry.count++ == 0)
+        entry.representative = std::string(value);
+    ++values;
+}
+
+std::string pattern_from_shapes(const ShapeHistogram& histogram)
+{
+    const auto& list = candidates();
+    std::vector<size_t> matched(list.size(), 0);
+    for (const auto& kv : histogram.shapes)
+        for (size_t c = 0; c < list.size(); ++c)
+            if (std::regex_match(kv.second.representative, list[c].re))
+                matched[c] += kv.second.count;
+
+    for (size_t c = 0; c < list.size(); ++c)
+        if (matched[c] == histogram.values)
+            return list[c].pattern;
+
+    int best = -1;
+    double best_rate = 0.0;
+    for (size_t c = 0; c < list.size(); ++c) {
+        double rate = histogram.values > 0 ? double(matched[c]) / histogram.values : 0.0;
+        if (rate > best_rate) {
+            best_rate = rate;
+            best = int(c);
+        }
+    }
+    if (best_rate >= 0.8 && best != -1)
+        return list[best].pattern;
+
+    return ".+";
+}
+
+std::unordered_map<std::string, std::string> discover_patterns(const DataFrame& data,
+                                                               const std::vector<ColumnProfile>& profiles)
+{
+    std::unordered_map<std::string, std::string> patterns;
+    for (size_t col = 0; col < profiles.size() && col < data.columns.size(); ++col)
+        patterns[data.columns[col]] = pattern_from_shapes(profiles[col].shapes);
+    return patterns;
+}
+
+std::unordered_map<std::string, std::string> discover_patterns(const DataFrame& data,
+                                                               int num_worker,
+                                                               size_t sample_size)
+{
+    return discover_patterns(data, profile_columns(data, num_worker, sample_size));
+}
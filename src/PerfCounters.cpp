@@ -0,0 +1,99 @@
+#include "../include/PerfCounters.h"
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static const uint64_t kConfigs[] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+PerfCounters::PerfCounters()
+{
+    for (int k = 0; k < kCounters; ++k)
+        fds[k] = -1;
+
+    for (int k = 0; k < kCounters; ++k) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = kConfigs[k];
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        int fd = int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+        if (fd < 0) {
+            error_ = std::string("perf_event_open: ") + std::strerror(errno);
+            for (int j = 0; j < k; ++j) {
+                close(fds[j]);
+                fds[j] = -1;
+            }
+            return;
+        }
+        fds[k] = fd;
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+    for (int k = 0; k < kCounters; ++k)
+        if (fds[k] >= 0)
+            close(fds[k]);
+}
+
+void PerfCounters::start()
+{
+    if (!available())
+        return;
+    for (int k = 0; k < kCounters; ++k) {
+        ioctl(fds[k], PERF_EVENT_IOC_RESET, 0);
+        ioctl(fds[k], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+PerfCounters::Values PerfCounters::stop()
+{
+    Values v;
+    if (!available())
+        return v;
+
+    uint64_t counts[kCounters];
+    for (int k = 0; k < kCounters; ++k) {
+        ioctl(fds[k], PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t data[3] = {0, 0, 0};   // value, time enabled, time running
+        if (read(fds[k], data, sizeof(data)) != ssize_t(sizeof(data)))
+            return v;
+        counts[k] = data[2] > 0 && data[2] < data[1]
+                        ? uint64_t(double(data[0]) * double(data[1]) / double(data[2]))
+                        : data[0];
+    }
+    v.valid = true;
+    v.cycles = counts[0];
+    v.instructions = counts[1];
+    v.cache_misses = counts[2];
+    v.branch_misses = counts[3];
+    return v;
+}
+
+#else
+
+PerfCounters::PerfCounters() : error_("hardware counters need Linux perf_event_open")
+{
+    for (int k = 0; k < kCounters; ++k)
+        fds[k] = -1;
+}
+
+PerfCounters::~PerfCounters() {}
+
+void PerfCounters::start() {}
+
+PerfCounters::Values PerfCounters::stop() { return Values(); }
+
+#endif
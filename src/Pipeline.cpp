@@ -0,0 +1,217 @@
+#include "../include/Pipeline.h"
+#include "../include/BoundedQueue.h"
+#include "../include/Compensative.h"
+#include "../include/CompensativeParameter.h"
+#include "../include/EncodedTable.h"
+#include "../include/Inference.h"
+#include "../include/ModelSnapshot.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <utility>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds_since(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+PipelineExecutor::PipelineExecutor(const std::map<std::string, AttrInfo>& attr_type,
+                                   const PipelineOptions& options)
+    : attr_type(attr_type), options(options) {}
+
+size_t PipelineExecutor::run(const std::string& dirty_path, const std::string& output_path)
+{
+    stage_times = {{"parse"}, {"preprocess"}, {"statistics"}, {"model"}, {"repair"}, {"write"}};
+    StageTime& parse_time = stage_times[0];
+    StageTime& pre_time = stage_times[1];
+    StageTime& stat_time = stage_times[2];
+    StageTime& model_time = stage_times[3];
+    StageTime& repair_time = stage_times[4];
+    StageTime& write_time = stage_times[5];
+    auto run_start = Clock::now();
+
+    std::ifstream file(dirty_path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file: " << dirty_path << std::endl;
+        return 0;
+    }
+
+    // The header is read up front so every stage knows the schema
+    DataFrame header;
+    std::string line;
+    if (std::getline(file, line)) {
+        header.columns = Dataset::split_line(line);
+        for (auto &col : header.columns)
+            col.erase(std::remove(col.begin(), col.end(), ' '), col.end());
+    }
+    if (attr_type.empty())
+        for (const auto &col : header.columns)
+            attr_type[col] = AttrInfo();
+
+    std::vector<std::string> attrs;
+    for (const auto &kv : attr_type)
+        attrs.push_back(kv.first);
+
+    const size_t chunk_rows = options.chunksize > 0 ? options.chunksize : 1;
+    const size_t capacity = options.queue_capacity > 0 ? options.queue_capacity : 1;
+
+    //-------------------- parse -> preprocess -> statistics ------------------
+    BoundedQueue<DataFrame> parsed(capacity);
+    BoundedQueue<std::pair<DataFrame, DataFrame>> preprocessed(capacity);
+
+    std::thread parser([&]() {
+        Dataset loader;
+        DataFrame chunk = header;
+        auto flush = [&]() {
+            auto start = Clock::now();
+            DataFrame real = loader.get_real_data(chunk, attr_type);
+            parse_time.seconds += seconds_since(start);
+            parse_time.chunks++;
+            parsed.push(std::move(real));
+            chunk.rows.clear();
+        };
+        auto start = Clock::now();
+        while (std::getline(file, line)) {
+            chunk.rows.push_back(Dataset::split_line(line, header.columns.size()));
+            if (chunk.rows.size() == chunk_rows) {
+                parse_time.seconds += seconds_since(start);
+                flush();
+                start = Clock::now();
+            }
+        }
+        parse_time.seconds += seconds_since(start);
+        if (!chunk.rows.empty())
+            flush();
+        parsed.close();
+    });
+
+    std::thread preprocessor([&]() {
+        Dataset loader;
+        DataFrame raw;
+        while (parsed.pop(raw)) {
+            auto start = Clock::now();
+            DataFrame processed = loader.pre_process_data(raw, attr_type);
+            pre_time.seconds += seconds_since(start);
+            pre_time.chunks++;
+            preprocessed.push({std::move(raw), std::move(processed)});
+        }
+        preprocessed.close();
+    });
+
+    DataFrame empty;
+    empty.columns = attrs;
+    Compensative compensative(empty, attr_type);
+    DataFrame processedData;
+    processedData.columns = attrs;
+
+    // With a sample size set, structure learning only ever sees a sample
+    // drawn while the rows stream past, instead of every processed row
+    const StructureOptions& so = options.structure;
+    const bool sampling = so.sample_size > 0;
+    int stratify = -1;
+    auto strat_it = std::find(attrs.begin(), attrs.end(), so.sample_stratify);
+    if (strat_it != attrs.end())
+        stratify = int(strat_it - attrs.begin());
+    RowSampler sampler(so.sample_size,
+                       so.recheck_sample_size > 0 ? so.recheck_sample_size : 4 * so.sample_size,
+                       stratify, so.seed);
+
+    auto schema = std::make_shared<EncodedSchema>(attrs);
+    EncodedTable dirtyTable(schema);
+    EncodedTable processedTable(schema);
+
+    std::pair<DataFrame, DataFrame> item;
+    while (preprocessed.pop(item)) {
+        auto start = Clock::now();
+        compensative.add_rows(item.second);
+        dirtyTable.append(item.first, "A Null Cell");
+        processedTable.append(item.second);
+        for (auto &row : item.second.rows) {
+            if (sampling)
+                sampler.add(row);
+            else
+                processedData.rows.push_back(std::move(row));
+        }
+        stat_time.seconds += seconds_since(start);
+        stat_time.chunks++;
+    }
+    parser.join();
+    preprocessor.join();
+
+    //-------------------------- freeze the model -----------------------------
+    auto model_start = Clock::now();
+    if (sampling)
+        processedData = sampler.sample(attrs);
+    BNStructure structure(processedData, options.model_path, options.model_choice, options.fix_edge, "", 1,
+                          options.structure);
+    if (sampling)
+        structure.set_recheck_data(sampler.recheck(attrs));
+    ModelSnapshotPtr model = ModelSnapshot::publish(compensative, structure.get_bn());
+
+    auto compParam = std::make_shared<CompensativeParameter>(attr_type, model, processedTable);
+    Inference inference(dirtyTable,
+                        processedTable,
+                        model,
+                        attr_type,
+                        compParam,
+                        options.infer_strategy,
+                        options.chunksize,
+                        1,
+                        options.tuple_prun,
+                        false);
+    model_time.seconds = seconds_since(model_start);
+    model_time.chunks = 1;
+
+    //--------------------------- repair -> write -----------------------------
+    BoundedQueue<EncodedTable> repaired(capacity);
+    size_t written = 0;
+
+    std::thread writer([&]() {
+        std::ofstream out(output_path);
+        if (!out.is_open())
+            std::cerr << "Failed to open output file: " << output_path << std::endl;
+        for (size_t a = 0; a < attrs.size(); ++a)
+            out << (a ? "," : "") << attrs[a];
+        out << '\n';
+
+        EncodedTable chunk;
+        while (repaired.pop(chunk)) {
+            auto start = Clock::now();
+            for (size_t i = 0; i < chunk.num_rows(); ++i) {
+                for (size_t a = 0; a < chunk.num_attrs(); ++a)
+                    out << (a ? "," : "") << chunk.value(i, a);
+                out << '\n';
+            }
+            written += chunk.num_rows();
+            write_time.seconds += seconds_since(start);
+            write_time.chunks++;
+        }
+    });
+
+    for (size_t begin = 0; begin < dirtyTable.num_rows(); begin += chunk_rows) {
+        auto start = Clock::now();
+        EncodedTable chunk = inference.repair_rows(begin, begin + chunk_rows);
+        repair_time.seconds += seconds_since(start);
+        repair_time.chunks++;
+        repaired.push(std::move(chunk));
+    }
+    repaired.close();
+    writer.join();
+
+    total_seconds = seconds_since(run_start);
+    return written;
+}
+
+void PipelineExecutor::print_stage_times() const
+{
+    std::cout << "=== Pipeline stage times ===" << std::endl;
+    for (const auto &st : stage_times)
+        std::cout << "  " << st.name << ": " << st.seconds << " s busy, "
+                  << st.chunks << " chunks" << std::endl;
+    std::cout << "  end-to-end: " << total_seconds << " s" << std::endl;
+}
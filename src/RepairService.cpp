@@ -0,0 +1,294 @@
+#include "../include/RepairService.h"
+#include "../include/Compensative.h"
+#include "../include/CompensativeParameter.h"
+#include "../include/Inference.h"
+#include "../include/ModelSnapshot.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static const char* const kNullCell = "A Null Cell";
+
+RepairService::RepairService(const DataFrame& training,
+                             const std::map<std::string, AttrInfo>& attr_type,
+                             const ServiceOptions& options)
+    : attr_type(attr_type), options(options)
+{
+    std::cout << "+++++++++repair service: learning model++++++++" << std::endl;
+    Dataset loader;
+    DataFrame processedData = loader.pre_process_data(training, attr_type);
+
+    Compensative compensative(processedData, attr_type);
+    compensative.build();
+
+    BNStructure structure(processedData, options.model_path, options.model_choice, options.fix_edge, "", 1,
+                          options.structure);
+    model = ModelSnapshot::publish(compensative, structure.get_bn());
+
+    schema = std::make_shared<EncodedSchema>(processedData.columns);
+    EncodedTable processedTable = EncodedTable::encode(processedData, schema);
+    EncodedTable dirtyTable = EncodedTable::encode(training, schema, kNullCell);
+
+    compensativeParameter = std::make_shared<CompensativeParameter>(attr_type, model, processedTable);
+    compensativeParameter->set_debug(false);
+
+    inference = std::make_shared<Inference>(dirtyTable,
+                                            processedTable,
+                                            model,
+                                            attr_type,
+                                            compensativeParameter,
+                                            options.infer_strategy,
+                                            1,
+                                            1,
+                                            options.tuple_prun,
+                                            false);
+
+    batcher = std::thread(&RepairService::batch_loop, this);
+    std::cout << "+++++++++repair service: ready++++++++" << std::endl;
+}
+
+RepairService::~RepairService()
+{
+    stop();
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    queue_cv.notify_all();
+    if (batcher.joinable())
+        batcher.join();
+}
+
+std::string RepairService::repair(const std::string& line)
+{
+    Request req;
+    req.line = line;
+    std::future<std::string> reply = req.reply.get_future();
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        pending.push_back(&req);
+    }
+    queue_cv.notify_one();
+    return reply.get();
+}
+
+std::string RepairService::answer(const std::string& line)
+{
+    return answer_all({line}).front();
+}
+
+std::vector<std::string> RepairService::answer_all(const std::vector<std::string>& lines)
+{
+    // Queue every row before waiting on any, so lines that arrived together
+    // are repaired in the same batch
+    std::vector<Request> reqs(lines.size());
+    std::vector<std::future<std::string>> replies;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        for (size_t i = 0; i < lines.size(); ++i) {
+            replies.push_back(reqs[i].reply.get_future());
+            if (lines[i] == "?columns") {
+                std::string header;
+                for (size_t a = 0; a < columns().size(); ++a)
+                    header += (a ? "," : "") + columns()[a];
+                reqs[i].reply.set_value(header);
+                continue;
+            }
+            reqs[i].line = lines[i];
+            pending.push_back(&reqs[i]);
+        }
+    }
+    queue_cv.notify_one();
+
+    std::vector<std::string> out;
+    for (auto &r : replies)
+        out.push_back(r.get());
+    return out;
+}
+
+void RepairService::batch_loop()
+{
+    std::vector<Request*> batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_cv.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty())
+                return;
+            // Take whatever has queued up; no waiting for a full batch
+            while (!pending.empty() && batch.size() < options.max_batch) {
+                batch.push_back(pending.front());
+                pending.pop_front();
+            }
+        }
+        repair_batch(batch);
+        batch.clear();
+    }
+}
+
+void RepairService::repair_batch(std::vector<Request*>& batch)
+{
+    const size_t m = schema->num_attrs();
+
+    // Remember the trained dictionary sizes so request-only values can be
+    // forgotten afterwards
+    std::vector<size_t> dict_sizes(m);
+    for (size_t a = 0; a < m; ++a)
+        dict_sizes[a] = schema->dict(a).size();
+
+    EncodedTable input(schema);
+    for (Request* req : batch) {
+        std::vector<std::string> values = Dataset::split_line(req->line, m);
+        values.resize(m);
+        for (auto &v : values)
+            if (v.empty()) v = kNullCell;
+        input.append_row(values);
+    }
+
+    EncodedTable output = input;
+    for (size_t i = 0; i < input.num_rows(); ++i)
+        inference->repair_row(input.row(i), output.row_data(i));
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        std::string line;
+        for (size_t a = 0; a < m; ++a) {
+            if (a) line += ',';
+            line += output.value(i, a);
+        }
+        batch[i]->reply.set_value(std::move(line));
+    }
+
+    for (size_t a = 0; a < m; ++a)
+        schema->dict(a).truncate(dict_sizes[a]);
+
+    batches++;
+    rows += batch.size();
+}
+
+void RepairService::serve_stream(std::istream& in, std::ostream& out)
+{
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        out << answer(line) << '\n';
+        out.flush();
+    }
+}
+
+bool RepairService::serve_unix(const std::string& socket_path)
+{
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        std::cerr << "socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path too long: " << socket_path << std::endl;
+        ::close(fd);
+        return false;
+    }
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    ::unlink(socket_path.c_str());
+
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(fd, 64) < 0) {
+        std::cerr << "Cannot listen on " << socket_path << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    listen_fd = fd;
+    serving = true;
+    std::cout << "Repair service listening on " << socket_path << std::endl;
+
+    std::vector<std::thread> connections;
+    while (serving) {
+        int conn = ::accept(fd, nullptr, nullptr);
+        if (conn < 0) {
+            if (!serving || errno != EINTR)
+                break;
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(conn_mutex);
+            connection_fds.push_back(conn);
+        }
+        connections.emplace_back(&RepairService::handle_connection, this, conn);
+    }
+
+    for (auto &t : connections)
+        t.join();
+    ::close(fd);
+    listen_fd = -1;
+    ::unlink(socket_path.c_str());
+    return true;
+}
+
+void RepairService::stop()
+{
+    serving = false;
+    int fd = listen_fd.load();
+    if (fd >= 0)
+        ::shutdown(fd, SHUT_RDWR);
+    std::lock_guard<std::mutex> lock(conn_mutex);
+    for (int c : connection_fds)
+        ::shutdown(c, SHUT_RDWR);
+}
+
+void RepairService::handle_connection(int fd)
+{
+    std::string buffer;
+    std::string response;
+    char chunk[4096];
+
+    while (true) {
+        ssize_t got = ::read(fd, chunk, sizeof(chunk));
+        if (got <= 0)
+            break;
+        buffer.append(chunk, got);
+
+        // Answer every complete line; keep the partial tail for later
+        std::vector<std::string> lines;
+        size_t start = 0, end;
+        while ((end = buffer.find('\n', start)) != std::string::npos) {
+            lines.push_back(buffer.substr(start, end - start));
+            if (!lines.back().empty() && lines.back().back() == '\r')
+                lines.back().pop_back();
+            start = end + 1;
+        }
+        buffer.erase(0, start);
+        if (lines.empty())
+            continue;
+
+        response.clear();
+        for (auto &r : answer_all(lines)) {
+            response += r;
+            response += '\n';
+        }
+
+        size_t sent = 0;
+        while (sent < response.size()) {
+            ssize_t n = ::write(fd, response.data() + sent, response.size() - sent);
+            if (n <= 0)
+                break;
+            sent += n;
+        }
+        if (sent < response.size())
+            break;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(conn_mutex);
+        connection_fds.erase(std::remove(connection_fds.begin(), connection_fds.end(), fd),
+                             connection_fds.end());
+    }
+    ::close(fd);
+}
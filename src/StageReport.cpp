@@ -0,0 +1,138 @@
+#include "../include/StageReport.h"
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sys/resource.h>
+
+static double process_cpu_seconds()
+{
+    timespec ts;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0)
+        return 0.0;
+    return double(ts.tv_sec) + double(ts.tv_nsec) * 1e-9;
+}
+
+long peak_rss_kb()
+{
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return usage.ru_maxrss;   // KiB on Linux
+}
+
+void StageReport::begin(const std::string& name, size_t rows)
+{
+    end();
+    StageMetrics m;
+    m.name = name;
+    m.rows = rows;
+    stages_.push_back(m);
+    running_ = true;
+    rss_start_kb_ = peak_rss_kb();
+    if (alloc::tracking()) {
+        alloc::reset_peak();
+        alloc_start_ = alloc::snapshot();
+        stages_.back().alloc_tracked = true;
+    }
+    cpu_start_ = process_cpu_seconds();
+    wall_start_ = std::chrono::steady_clock::now();
+    if (counters_)
+        counters_->start();
+}
+
+void StageReport::end()
+{
+    if (!running_)
+        return;
+    running_ = false;
+    StageMetrics& m = stages_.back();
+    if (counters_)
+        m.counters = counters_->stop();
+    m.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start_).count();
+    m.cpu_seconds = process_cpu_seconds() - cpu_start_;
+    m.peak_rss_delta_kb = peak_rss_kb() - rss_start_kb_;
+    if (m.alloc_tracked) {
+        alloc::Counters now = alloc::snapshot();
+        m.allocs = now.allocs - alloc_start_.allocs;
+        m.alloc_bytes = now.bytes - alloc_start_.bytes;
+        m.peak_live_bytes = now.peak_live_bytes;
+        m.live_bytes_delta = now.live_bytes - alloc_start_.live_bytes;
+    }
+}
+
+bool StageReport::enable_counters()
+{
+    auto counters = std::make_unique<PerfCounters>();
+    if (!counters->available()) {
+        std::cerr << "Hardware counters unavailable (" << counters->error() << "), reporting without them" << std::endl;
+        return false;
+    }
+    counters_ = std::move(counters);
+    return true;
+}
+
+void StageReport::set_rows(size_t rows)
+{
+    if (!stages_.empty())
+        stages_.back().rows = rows;
+}
+
+void StageReport::set_size(const std::string& key, size_t value)
+{
+    if (!stages_.empty())
+        stages_.back().sizes[key] = value;
+}
+
+void StageReport::write_json(std::ostream& out) const
+{
+    double wall = 0.0, cpu = 0.0;
+    out << "{\n  \"stages\": [\n";
+    for (size_t k = 0; k < stages_.size(); ++k) {
+        const StageMetrics& m = stages_[k];
+        wall += m.wall_seconds;
+        cpu += m.cpu_seconds;
+        out << "    {\"name\": \"" << m.name << "\", \"rows\": " << m.rows
+            << ", \"wall_seconds\": " << m.wall_seconds
+            << ", \"cpu_seconds\": " << m.cpu_seconds
+            << ", \"peak_rss_delta_kb\": " << m.peak_rss_delta_kb
+            << ", \"rows_per_second\": " << m.rows_per_second()
+            << ", \"sizes\": {";
+        bool first = true;
+        for (const auto& kv : m.sizes) {
+            out << (first ? "" : ", ") << "\"" << kv.first << "\": " << kv.second;
+            first = false;
+        }
+        out << "}";
+        if (m.alloc_tracked)
+            out << ", \"allocations\": {\"count\": " << m.allocs
+                << ", \"bytes\": " << m.alloc_bytes
+                << ", \"peak_live_bytes\": " << m.peak_live_bytes
+                << ", \"live_bytes_delta\": " << m.live_bytes_delta << "}";
+        if (m.counters.valid) {
+            const PerfCounters::Values& c = m.counters;
+            const double rows = m.rows ? double(m.rows) : 1.0;
+            out << ", \"counters\": {\"cycles\": " << c.cycles
+                << ", \"instructions\": " << c.instructions
+                << ", \"cache_misses\": " << c.cache_misses
+                << ", \"branch_misses\": " << c.branch_misses
+                << ", \"ipc\": " << c.ipc()
+                << ", \"cache_misses_per_row\": " << c.cache_misses / rows
+                << ", \"branch_misses_per_row\": " << c.branch_misses / rows << "}";
+        }
+        out << "}" << (k + 1 < stages_.size() ? ",\n" : "\n");
+    }
+    out << "  ],\n  \"total_wall_seconds\": " << wall
+        << ",\n  \"total_cpu_seconds\": " << cpu
+        << ",\n  \"peak_rss_kb\": " << peak_rss_kb() << "\n}\n";
+}
+
+bool StageReport::write_json(const std::string& path) const
+{
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Cannot write stage report to " << path << std::endl;
+        return false;
+    }
+    write_json(out);
+    return true;
+}
@@ -0,0 +1,72 @@
+#include "../include/ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t num_threads)
+{
+    for (size_t t = 1; t < num_threads; ++t)
+        workers.emplace_back(&ThreadPool::worker_loop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &w : workers)
+        w.join();
+}
+
+void ThreadPool::run(size_t count, const std::function<void(size_t)>& fn)
+{
+    if (count == 0)
+        return;
+    if (workers.empty() || count == 1) {
+        for (size_t i = 0; i < count; ++i)
+            fn(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &fn;
+        task_count = count;
+        next = 0;
+        active = workers.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    drain();
+
+    // fn must outlive every worker's last call
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return active == 0; });
+    task = nullptr;
+}
+
+void ThreadPool::drain()
+{
+    for (size_t i = next++; i < task_count; i = next++)
+        (*task)(i);
+}
+
+void ThreadPool::worker_loop()
+{
+    size_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+        drain();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--active == 0)
+                done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,149 @@
+#include "../include/Trace.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace trace {
+
+namespace {
+
+struct Event {
+    const char* name;
+    int64_t arg;
+    uint64_t start_ns;
+    uint64_t dur_ns;
+};
+
+// Events of one thread in fixed-size chunks that never move, so the
+// writer can read the first `count` events while the owner appends
+struct ThreadBuffer {
+    static const size_t kChunk = 4096;
+    static const size_t kChunks = kMaxEventsPerThread / kChunk;
+
+    size_t tid = 0;
+    std::unique_ptr<Event[]> chunks[kChunks];
+    std::atomic<size_t> count{0};
+    std::atomic<size_t> dropped{0};
+
+    void push(const Event& e)
+    {
+        size_t n = count.load(std::memory_order_relaxed);
+        if (n >= kMaxEventsPerThread) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (n % kChunk == 0 && !chunks[n / kChunk])
+            chunks[n / kChunk].reset(new Event[kChunk]);
+        chunks[n / kChunk][n % kChunk] = e;
+        count.store(n + 1, std::memory_order_release);
+    }
+
+    const Event& at(size_t k) const { return chunks[k / kChunk][k % kChunk]; }
+};
+
+// Buffers are registered once per thread and kept until exit, so spans of
+// finished threads (e.g. a ThreadPool torn down) are still written
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+Registry& registry()
+{
+    static Registry* r = new Registry();   // never destroyed: threads may outlive statics
+    return *r;
+}
+
+ThreadBuffer& local_buffer()
+{
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffer = r.buffers.back().get();
+        buffer->tid = r.buffers.size();
+    }
+    return *buffer;
+}
+
+void write_escaped(std::ostream& out, const char* s)
+{
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\')
+            out << '\\';
+        out << *s;
+    }
+}
+
+// Trace timestamps are in microseconds; keeps the nanoseconds as decimals
+void write_us(std::ostream& out, uint64_t ns)
+{
+    char text[32];
+    std::snprintf(text, sizeof(text), "%llu.%03llu", (unsigned long long)(ns / 1000),
+                  (unsigned long long)(ns % 1000));
+    out << text;
+}
+
+}  // namespace
+
+uint64_t now_ns()
+{
+    using Clock = std::chrono::steady_clock;
+    static const Clock::time_point epoch = Clock::now();
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count());
+}
+
+void record(const char* name, int64_t arg, uint64_t start_ns, uint64_t end_ns)
+{
+    local_buffer().push({name, arg, start_ns, end_ns - start_ns});
+}
+
+size_t dropped()
+{
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    size_t total = 0;
+    for (const auto& b : r.buffers)
+        total += b->dropped.load(std::memory_order_relaxed);
+    return total;
+}
+
+bool write_json(const std::string& path)
+{
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Cannot write trace to " << path << std::endl;
+        return false;
+    }
+
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    bool first = true;
+    for (const auto& b : r.buffers) {
+        const size_t n = b->count.load(std::memory_order_acquire);
+        for (size_t k = 0; k < n; ++k) {
+            const Event& e = b->at(k);
+            out << (first ? "\n" : ",\n") << "{\"name\": \"";
+            first = false;
+            write_escaped(out, e.name);
+            out << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << b->tid << ", \"ts\": ";
+            write_us(out, e.start_ns);
+            out << ", \"dur\": ";
+            write_us(out, e.dur_ns);
+            if (e.arg >= 0)
+                out << ", \"args\": {\"arg\": " << e.arg << "}";
+            out << "}";
+        }
+    }
+    out << "\n]}\n";
+    return true;
+}
+
+}  // namespace trace
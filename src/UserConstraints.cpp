@@ -1,5 +1,10 @@
 #include "../include/UserConstraints.h"
 #include "../dataset.h"  // Include dataset.h to get DataFrame definition
+#include "../include/PatternDiscovery.h"
+#include "../include/ColumnProfile.h"
+#include "../include/JsonReader.h"
+#include <cstdlib>
+#include <functional>
 #include <sstream>
 #include <algorithm>
 #include <cctype>
@@ -50,29 +55,68 @@ std::unordered_map<std::string, std::unordered_map<std::string, std::string>> UC
     return res;
 }
 
-// Default setting to find min/max values for an attribute
-std::string UC::default_setting(const std::string& attr, const std::string& type, const std::string& name) {
-    std::vector<std::string> domain = get_column_values(attr);
-    std::string result;
+const std::map<std::string, AttrInfo>& UC::get_attr_info() const {
+    return info;
+}
+
+// A bound is a number, or for non-numerical attributes an example value
+// (as default_setting gives) whose length it is
+static bool parse_bound(const std::string& s, bool numerical, double& out) {
+    if (s.empty())
+        return false;
+    const char* begin = s.c_str();
+    char* end = nullptr;
+    double v = std::strtod(begin, &end);
+    if (end != begin && (numerical || *end == '\0')) {
+        out = v;
+        return true;
+    }
+    if (numerical)
+        return false;
+    out = double(s.size());
+    return true;
+}
+
+static bool is_yes(const std::string& s) {
+    return s == "Y" || s == "y" || s == "true";
+}
+
+AttrInfo UC::to_attr_info(const Fields& fields) {
+    auto get = [&](const char* key) {
+        auto it = fields.find(key);
+        return it == fields.end() ? std::string() : it->second;
+    };
+    std::string type = get("type");
+    AttrInfo a(get("pattern"), type.empty() ? "Unknown" : type, is_yes(get("AllowNull")));
+    std::string repairable = get("repairable");
+    a.repairable = repairable.empty() || is_yes(repairable);
+    parse_bound(get("min_length"), a.numerical, a.min_v);
+    parse_bound(get("max_length"), a.numerical, a.max_v);
+    return a;
+}
 
-    if (type == "Categorical") {
-        if (name == "min_v") {
-            result = *std::min_element(domain.begin(), domain.end(), 
-                [](const std::string& a, const std::string& b) { return a.size() < b.size(); });
-        }
-        else if (name == "max_v") {
-            result = *std::max_element(domain.begin(), domain.end(), 
-                [](const std::string& a, const std::string& b) { return a.size() < b.size(); });
-        }
-    } 
-    else if (type == "Numerical") {
-        result = *std::min_element(domain.begin(), domain.end());
-        if (name == "max_v") {
-            result = *std::max_element(domain.begin(), domain.end());
-        }
+// Default min/max for an attribute, read from its column profile: the
+// smallest/largest number for Numerical attributes, else the shortest/longest
+// length. Empty if the column has no such values.
+std::string UC::default_setting(const std::string& attr, const std::string& type, const std::string& name) {
+    size_t col = std::distance(data.columns.begin(),
+        std::find(data.columns.begin(), data.columns.end(), attr));
+    if (col == data.columns.size()) return "";
+    const ColumnProfile& p = profile()[col];
+    bool is_min = name == "min_v";
+
+    if (type == "Numerical") {
+        if (p.numeric == 0) return "";
+        return is_min ? p.min_number_text : p.max_number_text;
     }
+    if (p.non_null() == 0) return "";
+    return std::to_string(is_min ? p.min_length : p.max_length);
+}
 
-    return result;
+const std::vector<ColumnProfile>& UC::profile(int num_worker) {
+    if (profiles.size() != data.columns.size())
+        profiles = profile_columns(data, num_worker);
+    return profiles;
 }
 
 // Build the user constraints for a specific attribute
@@ -89,103 +133,71 @@ void UC::build(const std::string& attr, const std::string& type, const std::stri
 
     res[attr] = {{"type", type}, {"min_length", min_value}, {"max_length", max_value}, 
                  {"AllowNull", null_allow}, {"repairable", repairable}, {"pattern", pattern}};
+    info[attr] = to_attr_info(res[attr]);
     std::cout << "User constraint for attribute '" << attr << "' has been set." << std::endl;
 }
 
 
-// Helper function to trim whitespace from both ends of a string
-std::string trim(const std::string &s) {
-    auto start = s.begin();
-    while (start != s.end() && std::isspace(*start)) {
-        start++;
-    }
-    auto end = s.end();
-    do {
-        end--;
-    } while (std::distance(start, end) > 0 && std::isspace(*end));
-    return std::string(start, end + 1);
-}
-
-void UC::build_from_json(const std::string& jpath) {
-    try {
-        std::ifstream file(jpath);
-        if (!file.is_open()) {
-            throw std::runtime_error("Cannot open JSON file.");
-        }
-        std::string line;
-        std::string currentAttr = "";
-        std::unordered_map<std::string, std::string> constraintMap;
-        bool insideBlock = false;
+// Fills UC fields from the events of a JsonReader: the top-level keys are
+// attributes, the fields of their objects constraints. Anything nested
+// deeper is skipped. Booleans become "Y"/"N" and null an empty string.
+class ConstraintJsonHandler : public JsonHandler {
+public:
+    explicit ConstraintJsonHandler(std::function<void(const std::string&, const UC::Fields&)> done)
+        : done(std::move(done)) {}
 
-        while (std::getline(file, line)) {
-            line = trim(line);
-            // Skip empty lines or just braces
-            if (line.empty() || line == "{" || line == "}" || line == "},")
-                continue;
-
-            // Check if line defines an attribute block e.g., "ounces": {
-            size_t pos = line.find("\":");
-            if (pos != std::string::npos && line.find("{") != std::string::npos) {
-                // Finish previous attribute block if any
-                if (insideBlock && !currentAttr.empty()) {
-                    res[currentAttr] = constraintMap;
-                    constraintMap.clear();
-                }
-                // Extract attribute name, removing leading quote
-                currentAttr = line.substr(1, pos - 1);
-                insideBlock = true;
-                continue;
-            }
-
-            // If inside a block, parse key-value pairs until a closing brace
-            if (insideBlock) {
-                // If we reach the end of the block for an attribute
-                if (line[0] == '}') {
-                    // Save current attribute's constraints
-                    if (!currentAttr.empty()) {
-                        res[currentAttr] = constraintMap;
-                    }
-                    constraintMap.clear();
-                    currentAttr = "";
-                    insideBlock = false;
-                    continue;
-                }
+    void start_object() override {
+        if (stack.size() == 1)
+            fields.clear();
+        stack.push_back('{');
+    }
+    void end_object() override {
+        stack.pop_back();
+        if (stack.size() == 1)
+            done(attr, fields);
+    }
+    void start_array() override { stack.push_back('['); }
+    void end_array() override { stack.pop_back(); }
+
+    void key(const std::string& name) override {
+        if (stack.size() == 1)
+            attr = name;
+        else if (stack.size() == 2)
+            field = name;
+    }
+    void string_value(const std::string& v) override { value(v); }
+    void number(const std::string& text, double) override { value(text); }
+    void boolean(bool v) override { value(v ? "Y" : "N"); }
+    void null() override { value(""); }
+
+private:
+    void value(const std::string& v) {
+        if (stack.size() == 2 && stack.back() == '{')
+            fields[field] = v;
+    }
 
-                // Expecting a line like "type": "Numerical", or "min_length": 0,
-                // Remove comma at the end if present
-                if (line.back() == ',')
-                    line.pop_back();
-                // Split at colon
-                size_t colonPos = line.find(':');
-                if (colonPos != std::string::npos) {
-                    std::string key = trim(line.substr(0, colonPos));
-                    std::string value = trim(line.substr(colonPos + 1));
-                    // Remove quotes from key if present
-                    if (!key.empty() && key.front() == '"') {
-                        key = key.substr(1, key.size() - 2);
-                    }
-                    // Process value: remove quotes if string, or handle null
-                    if (!value.empty() && value.front() == '"') {
-                        // Remove leading and trailing quotes
-                        value = value.substr(1, value.size() - 2);
-                    } else if (value == "null") {
-                        value = "";  // convert JSON null to empty string
-                    }
-                    // Store the key-value pair in constraintMap
-                    constraintMap[key] = value;
-                }
-            }
-        }
-        // If the last attribute block wasn't closed with a '}', add it now.
-        if (insideBlock && !currentAttr.empty()) {
-            res[currentAttr] = constraintMap;
-        }
+    std::function<void(const std::string&, const UC::Fields&)> done;
+    std::vector<char> stack;
+    std::string attr, field;
+    UC::Fields fields;
+};
 
-        file.close();
-    } catch (const std::exception& e) {
-        std::cout << "Error reading JSON: " << e.what() << std::endl;
+void UC::build_from_json(const std::string& jpath) {
+    std::ifstream file(jpath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cout << "Error reading JSON: Cannot open JSON file." << std::endl;
+        return;
     }
+
+    ConstraintJsonHandler handler([this](const std::string& attr, const Fields& fields) {
+        res[attr] = fields;
+        info[attr] = to_attr_info(fields);
+    });
+    JsonReader reader(file);
+    if (!reader.parse(handler))
+        std::cout << "Error reading JSON: " << reader.error() << std::endl;
 }
+
 // Print the user constraints for an attribute
 void UC::edit(const std::string& df_attr, const std::string& uc_attr, const std::string& uc_v) {
     if (res.find(df_attr) == res.end()) {
@@ -199,106 +211,21 @@ void UC::edit(const std::string& df_attr, const std::string& uc_attr, const std:
     }
 
     res[df_attr][uc_attr] = uc_v;
+    info[df_attr] = to_attr_info(res[df_attr]);
     std::cout << "Attribute modified" << std::endl;
 }
 
-// Discover patterns in each column using regex
-std::unordered_map<std::string, std::string> UC::PatternDiscovery() {
-    std::unordered_map<std::string, std::string> patterns;
-    for (const auto& col : data.columns) {
-        std::string pattern = discover_pattern_in_column(col);
-        patterns[col] = pattern;
-    }
-    return patterns;
-}
-
-// Helper function to extract values from a specific column
-std::vector<std::string> UC::get_column_values(const std::string& attr) {
-    std::vector<std::string> values;
-    for (const auto& row : data.rows) {
-        values.push_back(row[std::distance(data.columns.begin(), 
-            std::find(data.columns.begin(), data.columns.end(), attr))]);
-    }
-    return values;
+// Discover patterns in each column from their character-class shapes
+std::unordered_map<std::string, std::string> UC::PatternDiscovery(int num_worker, size_t sample_size) {
+    if (sample_size > 0 && sample_size < data.rows.size())
+        return discover_patterns(data, num_worker, sample_size);
+    return discover_patterns(data, profile(num_worker));
 }
 
-// Placeholder function to simulate pattern discovery
-
-// Improved helper function to extract a more advanced pattern from a column's data
+// Pattern of a single column, from its profile
 std::string UC::discover_pattern_in_column(const std::string& col) {
-    std::vector<std::string> values = get_column_values(col);
-    if (values.empty()) return "";
-
-    // Preprocess: trim whitespace for each value (optional)
-    for (auto &val : values) {
-        // A simple trim (you could use a more robust version)
-        size_t start = val.find_first_not_of(" \t");
-        size_t end = val.find_last_not_of(" \t");
-        if (start != std::string::npos && end != std::string::npos)
-            val = val.substr(start, end - start + 1);
-    }
-
-    // Define candidate regex patterns.
-    // std::vector<std::pair<std::string, std::regex>> candidates = {
-    //     {"\\d+(\\.\\d+)?", std::regex("^\\d+(\\.\\d+)?$")},                  // Numeric (integer or float)
-    //     {"[A-Za-z]+", std::regex("^[A-Za-z]+$")},                             // Alphabetical only
-    //     {"[A-Za-z0-9]+", std::regex("^[A-Za-z0-9]+$")},                       // Alphanumeric
-    //     {"\\d{4}-\\d{2}-\\d{2}", std::regex("^\\d{4}-\\d{2}-\\d{2}$")},       // Date in YYYY-MM-DD
-    //     {"\\w+@\\w+\\.\\w+", std::regex("^\\w+@\\w+\\.\\w+$")},               // Email (simple)
-    //     {"[A-Za-z\\.\\s]+", std::regex("^[A-Za-z\\.\\s]+$")}                  // Allow letters, dots, and spaces
-    // };
-
-    std::vector<std::pair<std::string, std::regex>> candidates = {
-    {"\\d+(\\.\\d+)?%?", std::regex("^\\d+(\\.\\d+)?%?$")},            // Numeric (integer or float) with optional %
-    {"[A-Za-z]+", std::regex("^[A-Za-z]+$")},                          // Alphabetical only
-    {"[A-Za-z0-9]+", std::regex("^[A-Za-z0-9]+$")},                    // Alphanumeric
-    {"\\d{4}-\\d{2}-\\d{2}", std::regex("^\\d{4}-\\d{2}-\\d{2}$")},    // Date in YYYY-MM-DD
-    {"\\w+@\\w+\\.\\w+", std::regex("^\\w+@\\w+\\.\\w+$")},            // Email (simple)
-    {"[A-Za-z\\.\\s]+", std::regex("^[A-Za-z\\.\\s]+$")}               // Allow letters, dots, and spaces
-};
-
-
-
-    // First, check for a perfect match.
-    for (const auto &candidate : candidates) {
-        bool allMatch = true;
-        for (const auto &val : values) {
-            if (val.empty()) continue;
-            if (!std::regex_match(val, candidate.second)) {
-                allMatch = false;
-                break;
-            }
-        }
-        if (allMatch) {
-            return candidate.first;
-        }
-    }
-
-    // Compute match rate for each candidate.
-    int bestCandidateIndex = -1;
-    double bestMatchRate = 0.0;
-    for (size_t i = 0; i < candidates.size(); i++) {
-        int matchCount = 0;
-        int total = 0;
-        for (const auto &val : values) {
-            if (val.empty()) continue;
-            total++;
-            if (std::regex_match(val, candidates[i].second)) {
-                matchCount++;
-            }
-        }
-        double rate = (total > 0) ? static_cast<double>(matchCount) / total : 0.0;
-        if (rate > bestMatchRate) {
-            bestMatchRate = rate;
-            bestCandidateIndex = static_cast<int>(i);
-        }
-    }
-
-    // Lowered threshold to 0.7 for example purposes
-    if (bestMatchRate >= 0.8 && bestCandidateIndex != -1) {
-        return candidates[bestCandidateIndex].first;
-    }
-
-    // Fallback generic pattern.
-    return ".+";
-}
\ No newline at end of file
+    size_t idx = std::distance(data.columns.begin(),
+        std::find(data.columns.begin(), data.columns.end(), col));
+    if (idx == data.columns.size()) return "";
+    return pattern_from_shapes(profile()[idx].shapes);
+}
@@ -1,11 +1,15 @@
 #include "../include/BNStructure.h"
+#include "../include/ModelFile.h"
+#include <cstdio>
 #include <iostream>
 #include <vector>
 
 int main()
 {
-    // Dummy dataset: 3 attributes, 4 samples
-    std::vector<std::vector<std::string>> data = {
+    // Dummy dataset: 3 attributes, 14 samples
+    DataFrame data;
+    data.columns = {"outlook", "temperature", "humidity"};
+    data.rows = {
         {"sunny", "hot", "high"},
         {"sunny", "hot", "high"},
         {"overcast", "hot", "high"},
@@ -23,8 +27,8 @@ int main()
 
     // Fix edges for testing (optional, for "fix" mode)
     std::vector<Edge> fixed_edges = {
-        Edge("Attr0", "Attr1"),
-        Edge("Attr1", "Attr2")};
+        Edge("outlook", "temperature"),
+        Edge("temperature", "humidity")};
 
     // === Test 1: using fixed edges ===
     std::cout << "==== Test FIXED structure ====" << std::endl;
@@ -45,5 +49,27 @@ int main()
         }
     }
 
-    return 0;
-}
\ No newline at end of file
+    // === Test 3: saving and loading a model file ===
+    std::cout << "\n==== Test model file round trip ====" << std::endl;
+    BNStructure bn_save(data, "", "fix", fixed_edges, "test_model.bin");
+    bn_save.get_bn();
+
+    BNStructure bn_load(data, "test_model.bin", "fix", {});
+    BNResult result_load = bn_load.get_bn();
+    bool same = result_load.full_graph.adjacency_list == result_fixed.full_graph.adjacency_list;
+    std::cout << "Loaded graph matches saved graph: " << (same ? "yes" : "NO") << std::endl;
+
+    ModelFile file;
+    if (file.open("test_model.bin"))
+    {
+        int t = file.attr_id("temperature");
+        int o = file.attr_id("outlook");
+        // P(temperature = hot | outlook = sunny) = 2/5
+        double p = file.cpt(t, {file.lookup(o, "sunny")}, file.lookup(t, "hot"));
+        std::cout << "P(temperature=hot | outlook=sunny) = " << p << " (expected 0.4)" << std::endl;
+        same = same && p > 0.399 && p < 0.401;
+    }
+    std::remove("test_model.bin");
+
+    return same ? 0 : 1;
+}